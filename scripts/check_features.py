@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+# Runs the simulator on the small scenarios of tests/feature_traces and checks
+# the counters each scenario is built to exercise.
+import json
+import os
+import subprocess
+import sys
+
+BIN = "./coherence"
+TRACES = "./tests/feature_traces"
+
+# (scenario, protocol, cache_size assoc block_size, extra flags, expected fields)
+# A field is a key path into the JSON results, e.g. "snoop_filter.evictions" (list
+# elements by index, e.g. "hierarchy.levels.1.hits").
+CASES = [
+    # Core 1 reads the block core 0 holds: only core 0 is snooped.
+    ("snoop_presence", "MESI", "1024 1 32", ["--snoop-filter"],
+     {"snoop_filter.ideal": True, "snoop_filter.lookups": 2, "snoop_filter.snoops_sent": 1,
+      "snoop_filter.snoops_filtered": 1, "snoop_filter.max_tracked_blocks": 1,
+      "per_core_shared_accesses": [0, 1]}),
+    # The 9th block evicts the first from the 8-entry filter, which back-invalidates it.
+    ("snoop_capacity", "MESI", "1024 1 32", ["--snoop-filter-entries", "8"],
+     {"snoop_filter.ideal": False, "snoop_filter.evictions": 2, "snoop_filter.back_invalidations": 2,
+      "snoop_filter.max_tracked_blocks": 8, "per_core_misses": [10]}),
+    ("snoop_capacity", "MESI", "1024 1 32", ["--snoop-filter"],
+     {"snoop_filter.evictions": 0, "per_core_misses": [9]}),
+    # Core 0 writes a block (2 hops, from memory), core 1 reads it (forwarded to the owner,
+    # which writes it back), core 2 writes it (both holders invalidated, one sends the data).
+    ("directory", "Directory", "1024 1 32", [],
+     {"directory.requests": 3, "directory.indirections": 2, "directory.forwards": 1,
+      "directory.invalidations": 2, "directory.acks": 1, "directory.messages": 10,
+      "directory.network_bytes": 10 * 8 + 3 * 32, "bus_data_traffic_bytes": 2 * 32}),
+    # The forwarder moves from core 0 to 1 to 2, then core 2 evicts the block: core 3 finds
+    # only Shared copies and fetches it from memory, where MESI's sharers answer.
+    ("forwarder", "MESIF", "1024 1 32", [],
+     {"mesif.forwarded_reads": 2, "mesif.shared_memory_fetches": 1, "memory_fetches": 3,
+      "per_core_shared_accesses": [0, 1, 1, 1]}),
+    ("forwarder", "MESI", "1024 1 32", [], {"memory_fetches": 2}),
+    # Core 1 reads a block that core 0 then writes four times without core 1 reading it again:
+    # at threshold 2 core 1 drops its copy after two updates and core 0 writes locally.
+    ("hybrid", "Hybrid", "1024 1 32", ["--update-threshold", "2"],
+     {"bus_updates": 2, "hybrid.self_invalidations": 1, "hybrid.local_writes": 2,
+      "hybrid.local_write_blocks": 1}),
+    ("hybrid", "Hybrid", "1024 1 32", ["--update-threshold", "0"],
+     {"bus_updates": 4, "hybrid.self_invalidations": 0, "hybrid.update_write_blocks": 1}),
+    ("hybrid", "Dragon", "1024 1 32", [], {"bus_updates": 4}),
+    # Cores 0 and 1 take turns reading then writing a block: core 0's second upgrade detects it,
+    # core 1's next read is exclusive and saves its upgrade, then core 0 reads it exclusively
+    # and evicts it unwritten (a misprediction, whose invalidation cancels the saving).
+    ("migratory", "MESI", "1024 1 32", ["--migratory"],
+     {"migratory.detected": 1, "migratory.exclusive_reads": 2, "migratory.mispredicted": 1,
+      "migratory.saved_upgrades": 1, "migratory.saved_transactions": 0, "bus_invalidations": 4}),
+    ("migratory", "MOESI", "1024 1 32", ["--migratory"],
+     {"migratory.detected": 1, "migratory.exclusive_reads": 2, "migratory.mispredicted": 1}),
+    ("migratory", "MESI", "1024 1 32", [], {"bus_invalidations": 3}),
+    # Core 0 writes a block and evicts it into its L2, then core 1 reads it (flushing core 0's
+    # dirty L2 copy), writes it (dropping core 0's L2 copy) and evicts it: core 0's read misses
+    # in its L2 and flushes core 1's copy.
+    ("stale_l2", "MESI", "1024 1 32", ["--l2", "4096:1"],
+     {"hierarchy.levels.1.hits": 0, "hierarchy.levels.1.coherence_invalidations": 1,
+      "hierarchy.levels.1.remote_flushes": 2}),
+    # The L2 evicts blocks the L1 still holds: only the inclusive hierarchy back-invalidates them.
+    ("inclusion", "MESI", "1024 2 32", ["--l2", "2048:1", "--inclusion", "inclusive"],
+     {"hierarchy.levels.1.back_invalidations": 3, "per_core_misses": [5]}),
+    ("inclusion", "MESI", "1024 2 32", ["--l2", "2048:1", "--inclusion", "non-inclusive"],
+     {"hierarchy.levels.1.back_invalidations": 0, "hierarchy.levels.1.hits": 1, "per_core_misses": [4]}),
+    # Three blocks cycle through a 2-way L1 set and a 2-way L2 set: only an exclusive hierarchy holds all three.
+    ("exclusive", "MESI", "1024 2 32", ["--l2", "2048:2", "--inclusion", "exclusive"],
+     {"hierarchy.levels.1.hits": 3, "hierarchy.levels.1.misses": 3}),
+    ("exclusive", "MESI", "1024 2 32", ["--l2", "2048:2", "--inclusion", "non-inclusive"],
+     {"hierarchy.levels.1.hits": 0}),
+    # Core 0 evicts a block into its L2, then receives it from core 1: the L2 copy is dropped,
+    # so core 1's write finds no other L2 copy.
+    ("exclusive_fill", "MESI", "1024 1 32", ["--l2", "4096:1", "--inclusion", "exclusive"],
+     {"hierarchy.levels.1.coherence_invalidations": 0, "per_core_shared_accesses": [1, 1]}),
+    # Blocks A B C D fill a 4-way set, A is re-referenced, then E, A, B, C, D follow.
+    # LRU evicts B for E, then B, C and D miss (evicting C, D, E).
+    ("replacement_reuse", "MESI", "1024 4 32", ["--replacement", "LRU"], {"per_core_misses": [8]}),
+    # PLRU's tree points E at C, then C at D and D at B: B stays.
+    ("replacement_reuse", "MESI", "1024 4 32", ["--replacement", "PLRU"], {"per_core_misses": [7]}),
+    # FIFO evicts A despite its hit, then A, B, C and D each evict the next way.
+    ("replacement_reuse", "MESI", "1024 4 32", ["--replacement", "FIFO"], {"per_core_misses": [9]}),
+    # Core 0's seed picks ways 1, 2, 2: E evicts B, B evicts C, C evicts B.
+    ("replacement_reuse", "MESI", "1024 4 32", ["--replacement", "Random"], {"per_core_misses": [7]}),
+    # A B C D, A re-referenced, then a scan of four new blocks and A again: LRU evicts A for
+    # the last of them, SRRIP ages the scan past A and keeps it.
+    ("replacement_scan", "MESI", "1024 4 32", ["--replacement", "LRU"], {"per_core_misses": [9]}),
+    ("replacement_scan", "MESI", "1024 4 32", ["--replacement", "SRRIP"], {"per_core_misses": [8]}),
+    # Five blocks cycle twice through a 4-way set: SRRIP misses on every access, BRRIP
+    # fills them distant so A and E evict each other while B, C and D stay.
+    ("replacement_thrash", "MESI", "1024 4 32", ["--replacement", "SRRIP"], {"per_core_misses": [10]}),
+    ("replacement_thrash", "MESI", "1024 4 32", ["--replacement", "BRRIP"], {"per_core_misses": [7]}),
+]
+
+
+def field(data, path):
+    for key in path.split("."):
+        data = data[int(key)] if isinstance(data, list) else data[key]
+    return data
+
+
+def main():
+    failed = 0
+    for scenario, protocol, geometry, flags, expected in CASES:
+        cmd = [BIN, protocol, os.path.join(TRACES, scenario + "_0.data")] + geometry.split() + flags + ["--json"]
+        name = " ".join(cmd[1:2] + [scenario] + cmd[3:-1])
+        data = json.loads(subprocess.run(cmd, check=True, capture_output=True, text=True).stdout)
+        errors = [f"{path} = {field(data, path)}, expected {value}"
+                  for path, value in expected.items() if field(data, path) != value]
+        if errors:
+            failed += 1
+            print(f"{name} FAILED: " + "; ".join(errors))
+        else:
+            print(f"{name} PASSED")
+
+    if failed == 0:
+        print("All feature checks passed!")
+    else:
+        print(f"{failed} feature check(s) failed.")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -5,7 +5,7 @@ OUTDIR="./tests/out_sweep"
 OUTFILE="results.csv"
 
 # Header line for CSV
-echo "Problem,Protocol,Sweep,Cache Size,Associativity,Block Size,Overall Execution Cycles,Bus Data Traffic Bytes,Bus Invalidations,Bus Updates,Execution Cycles,Compute Cycles,Loads,Stores,Idle Cycles,Hits,Misses,Private Accesses,Shared Accesses" > "$OUTFILE"
+echo "Problem,Protocol,Sweep,Cache Size,Associativity,Block Size,Overall Execution Cycles,Bus Data Traffic Bytes,Bus Invalidations,Bus Updates,Execution Cycles,Compute Cycles,Loads,Stores,Idle Cycles,Hits,Misses,Private Accesses,Shared Accesses,Replacement" > "$OUTFILE"
 
 for f in "$OUTDIR"/*.json; do
   # Example filename: Dragon_blackscholes_4096_2_32_cache.json
@@ -45,7 +45,8 @@ for f in "$OUTDIR"/*.json; do
       (safe_avg(.per_core_hits) | round),
       (safe_avg(.per_core_misses) | round),
       (safe_avg(.per_core_private_accesses) | round),
-      (safe_avg(.per_core_shared_accesses) | round)
+      (safe_avg(.per_core_shared_accesses) | round),
+      (.config.replacement // "LRU")
     ]
     | @csv
   ' "$f" >> "$OUTFILE"
@@ -58,6 +58,52 @@ for PROTOCOL in $PROTOCOLS; do
   done
 done
 
+# --- Lockstep check ---
+# A lockstep run of every protocol must print the same results as separate runs.
+for f in "$TRACES"/*_0.data; do
+  bm=$(basename "${f%_*}")
+  separate="$OUTDIR/separate_${bm}.json"
+  lockstep="$OUTDIR/lockstep_${bm}.json"
+  {
+    echo "["
+    first=1
+    for PROTOCOL in $PROTOCOLS; do
+      [[ "$first" == 1 ]] || echo ","
+      first=0
+      "$BIN" "$PROTOCOL" "$f" "$CACHE_SIZE" "$ASSOC" "$BLOCK" --json
+    done
+    echo "]"
+  } > "$separate"
+  "$BIN" "${PROTOCOLS// /,}" "$f" "$CACHE_SIZE" "$ASSOC" "$BLOCK" --json > "$lockstep"
+  if ! diff -u "$separate" "$lockstep"; then
+    echo "$lockstep FAILED"
+    failed_diff=$((failed_diff + 1))
+  else
+    echo "$lockstep PASSED"
+  fi
+done
+
+# --- Hybrid/Dragon check ---
+# Hybrid without self-invalidation (--update-threshold 0) must match Dragon on a benchmark with
+# sharing. Dragon's broadcasts stop at the first cache holding the block, so they are compared
+# on two cores (one other holder).
+dragon="$OUTDIR/dragon_2cores_blackscholes.json"
+hybrid="$OUTDIR/hybrid0_2cores_blackscholes.json"
+"$BIN" Dragon blackscholes "$CACHE_SIZE" "$ASSOC" "$BLOCK" --cores 2 --json | grep -v '"protocol"' > "$dragon"
+"$BIN" Hybrid blackscholes "$CACHE_SIZE" "$ASSOC" "$BLOCK" --cores 2 --update-threshold 0 --json | grep -v -e '"protocol"' -e '"hybrid"' > "$hybrid"
+if ! diff -u "$dragon" "$hybrid"; then
+  echo "$hybrid FAILED"
+  failed_diff=$((failed_diff + 1))
+else
+  echo "$hybrid PASSED"
+fi
+
+# --- Feature checks ---
+# Small scenarios with the counters they exercise (see scripts/check_features.py).
+if ! python3 ./scripts/check_features.py; then
+  failed_diff=$((failed_diff + 1))
+fi
+
 # --- Final Summary ---
 echo ""
 if [[ "$found" == 0 ]]; then
@@ -31,6 +31,10 @@ run_sweep() {
 
   echo "=== Running sweep: $var_name ==="
   for f in "$TRACES"/*_0.data; do
+    # Prefer the binary traces from `make convert` when present.
+    if [[ -f "${f%.data}.bin" ]]; then
+      f="${f%.data}.bin"
+    fi
     bn=$(basename "$f")
     bm="${bn%_*}"
     for proto in "${PROTOCOLS[@]}"; do
@@ -2,23 +2,45 @@
 #include "bus.hpp"
 #include "cache.hpp"
 
-// Handle bus broadcasts and adds to the bus traffic bytes and curr_core's idle cycles.
-//
-// Returns true if the cache line is shared.
-bool Bus::trigger_bus_broadcast(int curr_core, int bus_transaction_event, CacheLine *cache_line, int bus_traffic_words)
+// Copies the other caches holding the cache line's block into snoop_targets.
+// The holders are copied first, since snoops may invalidate lines.
+void Bus::collect_holders(int curr_core, CacheLine *cache_line)
 {
-    bool is_shared = false;
-    for (int k = 0; k < NUM_OF_CORES; k++)
+    const u64 *holders = snoop_filter.holders(cache_line->addr / block_bytes);
+    for (size_t w = 0; w < snoop_targets.size(); w++)
+        snoop_targets[w] = holders != nullptr ? holders[w] : 0;
+    snoop_targets[curr_core / 64] &= ~(1ULL << (curr_core % 64));
+}
+
+// Evicts block from a full snoop filter: every cache holding it is back-invalidated,
+// and writes it back if dirty (as on an eviction of the line).
+void Bus::evict_filter_entry(u32 block)
+{
+    const u64 *holders = snoop_filter.holders(block);
+    std::copy(holders, holders + snoop_targets.size(), snoop_targets.begin());
+    stats.incr_snoop_filter_evictions();
+    for (size_t w = 0; w < snoop_targets.size(); w++)
     {
-        if (k != curr_core)
+        for (u64 bits = snoop_targets[w]; bits != 0; bits &= bits - 1)
         {
-            is_shared = is_shared || caches[k]->trigger_snoop_event(bus_transaction_event, cache_line->addr);
+            const int k = 64 * w + __builtin_ctzll(bits);
+            bool dirty = false;
+            if (caches[k]->back_invalidate(block * block_bytes, dirty))
+            {
+                stats.incr_snoop_filter_back_invalidations();
+                evict_block(k, block * block_bytes, dirty);
+            }
         }
     }
+    assert(snoop_filter.holders(block) == nullptr);
+}
 
-    // Handle cache to cache data transfer.
-    u64 curr_time = Stats::get_exec_cycles(curr_core);
-    if (is_shared)
+// Waits for the bus for a broadcast of curr_core, followed by a cache-to-cache
+// transfer of bus_traffic_words if from_cache is set.
+void Bus::complete_broadcast(int curr_core, CacheLine *cache_line, int bus_traffic_words, bool from_cache)
+{
+    u64 curr_time = request_time(curr_core);
+    if (from_cache)
     {
         // The bus transaction is serialized: a 1-cycle exclusive lock is required
         // for the command broadcast/arbitration at the start, and another 1-cycle exclusive lock
@@ -28,26 +50,206 @@ bool Bus::trigger_bus_broadcast(int curr_core, int bus_transaction_event, CacheL
         int transfer_cycles = bus_traffic_words * 2; // Sending a cache block with N words takes 2N cycles.
         u64 ready_time = request_bus(curr_time, transfer_cycles, bus_traffic_words > 0);
 
-        Stats::add_idle_cycles(curr_core, ready_time - curr_time);
-        Stats::add_bus_traffic_bytes(bus_traffic_words * WORD_BYTES);
+        stats.add_idle_cycles(curr_core, ready_time - curr_time);
+        stats.add_bus_traffic_bytes(bus_traffic_words * WORD_BYTES);
         cache_line->valid = true;
     }
     else
     {
         // Purely command broadcast (1 cycle lock).
         u64 ready_time = request_bus(curr_time, 0, false);
-        Stats::add_idle_cycles(curr_core, ready_time - curr_time);
+        stats.add_idle_cycles(curr_core, ready_time - curr_time);
     }
+}
+
+// Handle bus broadcasts and adds to the bus traffic bytes and curr_core's idle cycles.
+//
+// Returns true if the cache line is shared.
+bool Bus::trigger_bus_broadcast(int curr_core, int bus_transaction_event, CacheLine *cache_line, int bus_traffic_words)
+{
+    // Snoop the other caches holding the block, in core order.
+    bool is_shared = false;
+    collect_holders(curr_core, cache_line);
+    dirty_snooped = false;
 
+    u64 snoops = 0;
+    for (size_t w = 0; w < snoop_targets.size(); w++)
+    {
+        u64 bits = snoop_targets[w];
+        snoops += __builtin_popcountll(bits);
+        for (; bits != 0; bits &= bits - 1)
+        {
+            const int k = 64 * w + __builtin_ctzll(bits);
+            is_shared = is_shared || caches[k]->trigger_snoop_event(bus_transaction_event, cache_line->addr);
+        }
+    }
+    stats.record_snoops(snoops, caches.size() - 1);
+
+    // Handle cache to cache data transfer.
+    complete_broadcast(curr_core, cache_line, bus_traffic_words, is_shared);
     return is_shared;
 }
 
+// Handles bus broadcasts answered by a single responder (e.g. MESIF's forwarder): every cache
+// holding the block is snooped, and the data is only sent cache-to-cache if one of them
+// called supply_data while handling its snoop.
+//
+// Returns true if the cache line is shared. If no cache supplied the data, the cache line
+// stays invalid and must be fetched from main memory.
+bool Bus::trigger_bus_forward(int curr_core, int bus_transaction_event, CacheLine *cache_line, int bus_traffic_words)
+{
+    collect_holders(curr_core, cache_line);
+    data_supplied = false;
+    dirty_snooped = false;
+
+    u64 snoops = 0;
+    for (size_t w = 0; w < snoop_targets.size(); w++)
+    {
+        u64 bits = snoop_targets[w];
+        snoops += __builtin_popcountll(bits);
+        for (; bits != 0; bits &= bits - 1)
+            caches[64 * w + __builtin_ctzll(bits)]->trigger_snoop_event(bus_transaction_event, cache_line->addr);
+    }
+    stats.record_snoops(snoops, caches.size() - 1);
+
+    complete_broadcast(curr_core, cache_line, bus_traffic_words, data_supplied);
+    return snoops > 0;
+}
+
+// Returns the number of caches other than curr_core's holding the cache line's block.
+int Bus::count_other_holders(int curr_core, CacheLine *cache_line)
+{
+    collect_holders(curr_core, cache_line);
+    int holders = 0;
+    for (u64 bits : snoop_targets)
+        holders += __builtin_popcountll(bits);
+    return holders;
+}
+
+// Returns true if caches other than curr_core's still hold the cache line's block
+// (e.g. after a broadcast some of them self-invalidated on).
+bool Bus::has_other_holders(int curr_core, CacheLine *cache_line)
+{
+    return count_other_holders(curr_core, cache_line) > 0;
+}
+
 // Handles read and write with main memory for evicting/fetching a cache block.
 void Bus::access_main_memory(int curr_core, u64 duration_cycles)
 {
-    u64 curr_time = Stats::get_exec_cycles(curr_core);
+    u64 curr_time = request_time(curr_core);
     u64 ready_time = request_bus(curr_time, duration_cycles, true);
 
-    Stats::add_idle_cycles(curr_core, ready_time - curr_time);
-    Stats::add_bus_traffic_bytes(block_bytes); // Assume accessing main memory also adds bus traffic.
+    stats.add_idle_cycles(curr_core, ready_time - curr_time);
+    stats.add_bus_traffic_bytes(block_bytes); // Assume accessing main memory also adds bus traffic.
+}
+
+// Fetches the cache line's block for an L1 miss of curr_core, from the cache levels
+// below the L1s or from main memory.
+void Bus::fetch_block(int curr_core, CacheLine *cache_line)
+{
+    if (!hierarchy)
+    {
+        access_main_memory(curr_core, CYCLE_MEM_BLOCK_FETCH);
+        return;
+    }
+    const HierarchyCost cost = hierarchy->fetch(curr_core, cache_line->addr / block_bytes, stats.get_exec_cycles(curr_core));
+    cache_line->dirty = cache_line->dirty || cost.dirty;
+    charge(curr_core, cost);
+}
+
+// Handles a block evicted from curr_core's L1: dirty blocks are written back (and with
+// an exclusive hierarchy, clean blocks also move to the level below).
+void Bus::evict_block(int curr_core, u32 addr, bool dirty)
+{
+    migratory_evict(curr_core, addr / block_bytes);
+    if (!hierarchy)
+    {
+        if (dirty)
+            access_main_memory(curr_core, CYCLE_WRITEBACK_DIRTY);
+        return;
+    }
+    charge(curr_core, hierarchy->evict(curr_core, addr / block_bytes, dirty, stats.get_exec_cycles(curr_core)));
+}
+
+// Handles a block curr_core's L1 received cache-to-cache.
+void Bus::fill_block(int curr_core, u32 addr)
+{
+    if (hierarchy)
+        charge(curr_core, hierarchy->fill(curr_core, addr / block_bytes, stats.get_exec_cycles(curr_core)));
+}
+
+// Handles a write of curr_core's L1, which makes the other cores' copies below the L1s stale.
+void Bus::write_block(int curr_core, u32 addr)
+{
+    if (hierarchy)
+        hierarchy->write(curr_core, addr / block_bytes);
+}
+
+// Back-invalidates block in core's L1, for an inclusive hierarchy.
+bool Bus::back_invalidate(int core, u32 block, bool &dirty)
+{
+    if (!caches[core]->back_invalidate(block * block_bytes, dirty))
+        return false;
+    migratory_evict(core, block);
+    return true;
+}
+
+// Adds the latency of a hierarchy operation to curr_core: the private L2 cycles directly,
+// the LLC and main memory cycles (and the memory writebacks) as transactions on the bus.
+void Bus::charge(int curr_core, const HierarchyCost &cost)
+{
+    stats.add_idle_cycles(curr_core, cost.private_cycles);
+    if (cost.shared_cycles > 0)
+        access_main_memory(curr_core, cost.shared_cycles);
+    for (int i = 0; i < cost.memory_writebacks; i++)
+        access_main_memory(curr_core, CYCLE_WRITEBACK_DIRTY);
+}
+
+// Handles a request sent by curr_core to the home node of the cache line's block (directory
+// protocols), over a point-to-point network taking hop_latency cycles per message.
+//
+// The home node's full-map directory knows which other caches hold the block:
+// - None: the home node replies itself (2 hops), with the block from memory if needs_data is set
+//   (fetched by the cache through the memory channel).
+// - Otherwise the home node sends message to the first holder, or to every holder if exclusive
+//   is set, and they answer the requester directly (3 hops). With needs_data, the first holder
+//   also sends the block (2 cycles per word).
+// Adds to curr_core's idle cycles and the network statistics. The data sent over the network is
+// only counted there, not as bus traffic.
+//
+// Returns true if another cache held the block.
+bool Bus::directory_request(int curr_core, int message, bool exclusive, CacheLine *cache_line, bool needs_data)
+{
+    collect_holders(curr_core, cache_line);
+
+    u64 others = 0;
+    for (size_t w = 0; w < snoop_targets.size(); w++)
+    {
+        for (u64 bits = snoop_targets[w]; bits != 0; bits &= bits - 1)
+        {
+            const int k = 64 * w + __builtin_ctzll(bits);
+            if (others++ == 0 || exclusive)
+                caches[k]->trigger_snoop_event(message, cache_line->addr);
+        }
+    }
+
+    if (others == 0)
+    {
+        stats.add_idle_cycles(curr_core, 2 * hop_latency);
+        stats.record_directory_request(false, 0, 0, 0, needs_data ? block_bytes : 0);
+        return false;
+    }
+
+    u64 cycles = 3 * hop_latency;
+    if (needs_data)
+    {
+        cycles += 2 * (block_bytes / WORD_BYTES);
+        cache_line->valid = true;
+    }
+    stats.add_idle_cycles(curr_core, cycles);
+    if (exclusive)
+        stats.record_directory_request(true, 0, others, needs_data ? others - 1 : others, needs_data ? block_bytes : 0);
+    else
+        stats.record_directory_request(true, 1, 0, 0, needs_data ? block_bytes : 0);
+    return true;
 }
@@ -1,9 +1,16 @@
 #pragma once
+#include <vector>
+#include <memory>
 #include <algorithm>
 #include <cstdint>
-#include <unordered_set>
+#include <cassert>
 #include "utils/types.hpp"
+#include "utils/slot_calendar.hpp"
 #include "utils/stats.hpp"
+#include "snoop_filter.hpp"
+#include "migratory_detector.hpp"
+#include "hierarchy/memory_hierarchy.hpp"
+#include "sim_config.hpp"
 
 // The forward declaration is necessary here due to a cyclic reference.
 class Cache;
@@ -16,6 +23,9 @@ class Cache;
 // and that the bus is only locked during the first and last cycle,
 // for pipelining the bus transactions.
 // (only one core can broadcast/recieve in those cycles).
+//
+// With outstanding request slots (bus_slots > 0), the bus is instead modeled as a
+// split-transaction bus, see request_split_bus.
 class Bus
 {
 private:
@@ -23,10 +33,84 @@ private:
     std::vector<std::unique_ptr<Cache>> &caches;
 
     int block_bytes; // Number of bytes for a block for caches using the bus.
+    int hop_latency; // Cycles per message hop of the point-to-point network (directory protocols).
+    Stats &stats;
 
     // Indicates until when the bus is busy.
-    // Store the cycles at which the bus is exclusive (first and last cycles of a bus request).
-    std::unordered_set<u64> command_exclusive, data_exclusive;
+    // Store the cycles at which the bus is exclusive (first and last cycles of a bus request),
+    // from the earliest cycle a core can still request onwards.
+    SlotCalendar command_exclusive, data_exclusive;
+    u64 retired = 0; // No request starts before this cycle (see retire_before).
+
+    // Split-transaction bus: the cycles each outstanding request slot is held (empty if
+    // the bus is pipelined). In this mode command_exclusive holds the address phases and
+    // data_exclusive the data phases.
+    std::vector<SlotCalendar> slots;
+
+    // Presence of every block in the caches, so broadcasts only snoop its holders.
+    SnoopFilter snoop_filter;
+    std::vector<u64> snoop_targets; // Copy of the holders of the block being broadcast.
+    bool data_supplied = false;     // A snooped cache answers the current trigger_bus_forward.
+    bool dirty_snooped = false;     // A snooped cache held the block of the current broadcast dirty.
+
+    // Migratory sharing detector of the MESI and MOESI protocols (null if disabled).
+    std::unique_ptr<MigratoryDetector> migratory;
+
+    // Cache levels between the L1s and main memory (null if there are none).
+    std::unique_ptr<MemoryHierarchy> hierarchy;
+
+    // request_time returns the cycle a bus request of core starts at.
+    u64 request_time(int core) const { return std::max(stats.get_exec_cycles(core), retired); }
+
+    void collect_holders(int curr_core, CacheLine *cache_line);
+    void evict_filter_entry(u32 block);
+    int count_other_holders(int curr_core, CacheLine *cache_line);
+    bool back_invalidate(int core, u32 block, bool &dirty);
+    void charge(int curr_core, const HierarchyCost &cost);
+    void complete_broadcast(int curr_core, CacheLine *cache_line, int bus_traffic_words, bool from_cache);
+
+    // Returns end time of a split-transaction bus request.
+    //
+    // A request waits in the request queue for a free slot and a free address bus cycle,
+    // broadcasts its address for one cycle, then the responder (cache or memory) takes the
+    // rest of the duration, minus the block transfer, to prepare the data. The response then
+    // waits in the response queue until the data bus is free for the whole transfer
+    // (2 cycles per word, at most the duration). The slot is held from the address phase
+    // to the end of the data phase, so at most slots.size() requests are outstanding.
+    //
+    // The queues are kept as calendars, since requests do not arrive in time order.
+    u64 request_split_bus(u64 earliest, u64 duration_cycles, bool has_data)
+    {
+        const u64 data_cycles = has_data ? std::min<u64>(duration_cycles, 2 * (block_bytes / WORD_BYTES)) : 0;
+        const u64 latency = duration_cycles - data_cycles;
+
+        u64 start_time = earliest;
+        while (true)
+        {
+            start_time = command_exclusive.first_free(start_time);
+            const u64 ready_time = start_time + 1 + latency;
+            const u64 data_time = data_cycles > 0 ? data_exclusive.first_free_run(ready_time, data_cycles) : ready_time;
+            const u64 end_time = data_time + data_cycles;
+
+            // A later start cannot end earlier, so it is enough to retry after the first
+            // cycle some slot frees up past its first conflict.
+            u64 retry_time = UINT64_MAX;
+            for (auto &slot : slots)
+            {
+                const u64 busy = slot.first_busy(start_time, end_time);
+                if (busy == end_time)
+                {
+                    command_exclusive.mark(start_time);
+                    data_exclusive.mark(data_time, data_cycles);
+                    slot.mark(start_time, end_time - start_time);
+                    stats.record_bus_transaction(start_time - earliest, data_time - ready_time, data_cycles);
+                    return end_time;
+                }
+                retry_time = std::min(retry_time, slot.first_free(busy));
+            }
+            start_time = retry_time;
+        }
+    }
 
     // Returns end time after scheduling in FCFS ordering.
     // Requests are serviced in the order in which they arrive.
@@ -37,13 +121,11 @@ private:
     // The request duration is at least one cycle for the exclusive command bus broadcast.
     u64 request_bus(u64 earliest, u64 duration_cycles, bool has_data = false)
     {
+        if (!slots.empty())
+            return request_split_bus(earliest, duration_cycles, has_data);
+
         // Find first free start cycle (to acquire a command broadcast lock)
-        u64 start_time = earliest;
-        while (command_exclusive.find(start_time) != command_exclusive.end())
-        {
-            start_time++;
-        }
-        command_exclusive.insert(start_time);
+        u64 start_time = command_exclusive.reserve(earliest);
 
         // Get first free end cycle.
         // Assume that we should add command lock time of 1 cycle.
@@ -52,19 +134,103 @@ private:
         {
             // Assume that we should add data lock time of 1 cycle if data is transfered.
             end_time++; // to acquire a data transfer lock
-            while (data_exclusive.find(end_time) != data_exclusive.end())
-            {
-                end_time++;
-            }
-            data_exclusive.insert(end_time);
+            end_time = data_exclusive.reserve(end_time);
         }
 
         return end_time;
     }
 
 public:
-    Bus(std::vector<std::unique_ptr<Cache>> &caches, int block_bytes)
-        : caches(caches), block_bytes(block_bytes) {}
+    Bus(std::vector<std::unique_ptr<Cache>> &caches, const SimConfig &config, Stats &stats)
+        : caches(caches), block_bytes(config.block_size), hop_latency(config.hop_latency), stats(stats), slots(config.bus_slots),
+          snoop_filter(stats.num_cores(), config.cache_size / config.block_size, config.snoop_filter_entries),
+          snoop_targets(snoop_filter.presence_words())
+    {
+        stats.set_snoop_filter_capacity(config.snoop_filter_entries);
+        if (config.migratory)
+            migratory = std::make_unique<MigratoryDetector>();
+        if (config.hierarchy.enabled())
+            hierarchy = std::make_unique<MemoryHierarchy>(config.hierarchy, block_bytes, stats, [this](int core, u32 block, bool &dirty)
+                                                          { return back_invalidate(core, block, dirty); });
+    }
+
+    // set_presence records whether core holds block (called by the caches when a line
+    // becomes valid or invalid). A bounded snoop filter may first have to evict an entry.
+    void set_presence(u32 block, int core, bool present)
+    {
+        if (present && snoop_filter.full(block))
+            evict_filter_entry(snoop_filter.victim(block));
+        snoop_filter.set(block, core, present);
+        stats.record_snoop_filter_blocks(snoop_filter.tracked_blocks());
+    }
+
+    // retire_before forgets the bus cycles before cycle.
+    // Requests of cores whose clock is behind cycle (finished cores writing back a snooped
+    // line) start at cycle afterwards.
+    void retire_before(u64 cycle)
+    {
+        retired = std::max(retired, cycle);
+        command_exclusive.retire_before(cycle);
+        data_exclusive.retire_before(cycle);
+        for (auto &slot : slots)
+            slot.retire_before(cycle);
+    }
+
+    // migratory_read returns true if curr_core's read miss should be served as exclusive,
+    // i.e. the block is migratory and other caches hold it.
+    bool migratory_read(int curr_core, CacheLine *cache_line)
+    {
+        if (!migratory || count_other_holders(curr_core, cache_line) == 0)
+            return false;
+        switch (migratory->on_read_miss(cache_line->addr / block_bytes, curr_core))
+        {
+        case MigratoryDetector::Exclusive:
+            stats.incr_migratory_reads();
+            return true;
+        case MigratoryDetector::Mispredicted:
+            stats.incr_migratory_mispredictions();
+            return false;
+        default:
+            return false;
+        }
+    }
+
+    // migratory_write records a write of curr_core for the migratory sharing detector,
+    // before its bus transaction. upgrade is set if it invalidates a shared copy of curr_core.
+    void migratory_write(int curr_core, CacheLine *cache_line, bool upgrade)
+    {
+        if (!migratory)
+            return;
+        const int others = upgrade ? count_other_holders(curr_core, cache_line) : 0;
+        bool detected = false;
+        if (migratory->on_write(cache_line->addr / block_bytes, curr_core, upgrade, others, detected))
+            stats.incr_migratory_saved();
+        if (detected)
+            stats.incr_migratory_detections();
+    }
+
+    // migratory_evict records that curr_core's L1 dropped block, for the migratory sharing detector.
+    void migratory_evict(int curr_core, u32 block)
+    {
+        if (migratory && migratory->on_evict(block, curr_core))
+            stats.incr_migratory_mispredictions();
+    }
+
+    // supply_data is called by a snooped cache that sends the block of a trigger_bus_forward.
+    void supply_data() { data_supplied = true; }
+
+    // snoop_dirty is called by a snooped cache holding the block of the broadcast dirty, and
+    // snooped_dirty returns true if one did during the last broadcast.
+    void snoop_dirty() { dirty_snooped = true; }
+    bool snooped_dirty() const { return dirty_snooped; }
+
     bool trigger_bus_broadcast(int curr_core, int bus_transaction_event, CacheLine *cache_line, int num_cores);
+    bool trigger_bus_forward(int curr_core, int bus_transaction_event, CacheLine *cache_line, int bus_traffic_words);
+    bool has_other_holders(int curr_core, CacheLine *cache_line);
     void access_main_memory(int curr_core, u64 duration_cycles);
+    void fetch_block(int curr_core, CacheLine *cache_line);
+    void evict_block(int curr_core, u32 addr, bool dirty);
+    void fill_block(int curr_core, u32 addr);
+    void write_block(int curr_core, u32 addr);
+    bool directory_request(int curr_core, int message, bool exclusive, CacheLine *cache_line, bool needs_data);
 };
@@ -1,12 +1,17 @@
 #pragma once
 #include <vector>
 #include <cassert>
+#include <type_traits>
+#include <memory>
 #include "bus.cpp"
 #include "coherence_protocol.hpp"
 #include "utils/types.hpp"
 #include "utils/constants.hpp"
 #include "utils/utils.hpp"
 #include "utils/stats.hpp"
+#include "utils/simd_tags.hpp"
+#include "utils/arena.hpp"
+#include "replacement/replacement_policy.hpp"
 
 // Cache contains methods for accessing a cache line.
 class Cache
@@ -18,62 +23,127 @@ private:
     int num_sets;
     int curr_core;
     Bus &bus;
+    Stats &stats;
 
-    struct CacheSet
+    CoherenceProtocol *protocol;
+    std::unique_ptr<ReplacementPolicy> replacement;
+
+    // Lines and tag store (structure of arrays), indexed by set * assoc + way.
+    // The replacement metadata is kept by the replacement policy.
+    // All arrays are carved out of the simulation's arena (see arena_bytes).
+    // The valid bits mirror CacheLine::valid (which the protocols update), and are
+    // synchronized after every processor access and snoop.
+    CacheLine *lines;
+    u32 *tags;
+    u64 *valid_mask; // valid_words words per set, bit w set if way w is valid.
+    int valid_words;
+
+    CacheLine &line_at(int set_idx, int way) { return lines[static_cast<size_t>(set_idx) * assoc + way]; }
+
+    // set_valid also reports the line's presence changes to the bus snoop filter.
+    void set_valid(int set_idx, int way, bool valid)
     {
-        std::vector<CacheLine> cache_lines;
-        explicit CacheSet(int a) : cache_lines(a) {}
-    };
+        u64 &word = valid_mask[set_idx * valid_words + way / 64];
+        const u64 bit = 1ULL << (way % 64);
+        if (((word & bit) != 0) != valid)
+        {
+            const u32 tag = tags[static_cast<size_t>(set_idx) * assoc + way];
+            bus.set_presence(tag * static_cast<u32>(num_sets) + static_cast<u32>(set_idx), curr_core, valid);
+        }
+        word = valid ? (word | bit) : (word & ~bit);
+    }
 
-    CoherenceProtocol *protocol;
-    std::vector<CacheSet> sets;
+    // Geometry specialization: ASSOC is the associativity when it is one of the common
+    // (sweep) values, and 0 otherwise. The way loops of the specialized lookups are
+    // fully unrolled, and a set's valid bits fit in one word.
+    template <typename F>
+    auto with_assoc(F fn) const
+    {
+        switch (assoc)
+        {
+        case 1:
+            return fn(std::integral_constant<int, 1>{});
+        case 2:
+            return fn(std::integral_constant<int, 2>{});
+        case 4:
+            return fn(std::integral_constant<int, 4>{});
+        case 8:
+            return fn(std::integral_constant<int, 8>{});
+        case 16:
+            return fn(std::integral_constant<int, 16>{});
+        default:
+            return fn(std::integral_constant<int, 0>{});
+        }
+    }
 
-    // find_line returns null if not found.
-    CacheLine *find_line(int set_idx, u32 tag)
+    // find_way returns the way holding a valid line with the tag, or -1 if not found.
+    // All ways are compared at once (up to 64 per step), then masked with the valid bits.
+    template <int ASSOC>
+    int find_way_in(int set_idx, u32 tag) const
     {
-        auto &lines = sets[set_idx].cache_lines;
-        for (int w = 0; w < assoc; w++)
+        const int ways = ASSOC != 0 ? ASSOC : assoc;
+        const int words = ASSOC != 0 ? 1 : valid_words;
+        const u32 *set_tags = tags + static_cast<size_t>(set_idx) * ways;
+        const u64 *valid = valid_mask + static_cast<size_t>(set_idx) * words;
+        for (int i = 0; i < words; i++)
         {
-            if (lines[w].valid && lines[w].tag == tag)
-            {
-                return &lines[w];
-            }
+            u64 match = match_tags(set_tags + 64 * i, std::min(64, ways - 64 * i), tag) & valid[i];
+            if (match != 0)
+                return 64 * i + __builtin_ctzll(match);
         }
 
-        return nullptr;
+        return -1;
     }
 
-    CacheLine *find_victim(int set_idx)
+    template <int ASSOC>
+    int find_victim_in(int set_idx) const
     {
-        auto &lines = sets[set_idx].cache_lines;
+        const int ways = ASSOC != 0 ? ASSOC : assoc;
+        const int words = ASSOC != 0 ? 1 : valid_words;
 
         // First try finding invalid lines.
-        for (int w = 0; w < assoc; w++)
+        const u64 *valid = valid_mask + static_cast<size_t>(set_idx) * words;
+        for (int i = 0; i < words; i++)
         {
-            if (!lines[w].valid)
-            {
-                return &lines[w];
-            }
+            u64 invalid = ~valid[i];
+            if (i == words - 1 && ways % 64 != 0)
+                invalid &= (1ULL << (ways % 64)) - 1;
+            if (invalid != 0)
+                return 64 * i + __builtin_ctzll(invalid);
         }
 
-        // No free lines, so must evict LRU line (LRU replacement policy).
-        int victim_way = 0;
-        u64 oldest = lines[0].lru;
-        for (int w = 1; w < assoc; w++)
-        {
-            if (lines[w].lru < oldest)
-            {
-                oldest = lines[w].lru;
-                victim_way = w;
-            }
-        }
+        // No free lines, so the replacement policy chooses the victim.
+        return replacement->victim(set_idx);
+    }
+
+    int find_way(int set_idx, u32 tag) const
+    {
+        return with_assoc([&](auto a)
+                          { return find_way_in<decltype(a)::value>(set_idx, tag); });
+    }
 
-        return &lines[victim_way];
+    int find_victim(int set_idx) const
+    {
+        return with_assoc([&](auto a)
+                          { return find_victim_in<decltype(a)::value>(set_idx); });
     }
 
+    // Address decode with shifts and masks, when the block size and set count are
+    // powers of two (always the case in our sweeps). Divisions are the fallback.
+    bool pow2_geometry;
+    int block_shift;
+    int set_shift;
+    u32 set_mask;
+
     // decode_addr decodes an address and returns the [index, tag] as a pair.
     inline std::pair<int, u32> decode_address(u32 addr) const
     {
+        if (pow2_geometry)
+        {
+            u32 block_addr = addr >> block_shift;
+            return {static_cast<int>(block_addr & set_mask), block_addr >> set_shift};
+        }
+
         u32 block_addr = addr / block_bytes;
         int set = block_addr % num_sets;
         u32 tag = block_addr / num_sets;
@@ -81,18 +151,34 @@ private:
     }
 
 public:
-    Cache(int size_b, int assoc, int block_b, int curr_core, Bus &bus, CoherenceProtocol *proto)
-        : size_bytes(size_b), block_bytes(block_b), assoc(assoc), curr_core(curr_core), bus(bus), protocol(proto)
+    // arena_bytes returns the arena bytes needed by one cache of this geometry.
+    static size_t arena_bytes(int size_b, int assoc, int block_b)
+    {
+        size_t ways = static_cast<size_t>(size_b / block_b);
+        size_t sets = ways / assoc;
+        return Arena::bytes_for<CacheLine>(ways) + Arena::bytes_for<u32>(ways) + Arena::bytes_for<u64>(sets * ((assoc + 63) / 64));
+    }
+
+    Cache(int size_b, int assoc, int block_b, int curr_core, Bus &bus, Stats &stats, CoherenceProtocol *proto,
+          std::unique_ptr<ReplacementPolicy> replacement, Arena &arena)
+        : size_bytes(size_b), block_bytes(block_b), assoc(assoc), curr_core(curr_core), bus(bus), stats(stats), protocol(proto),
+          replacement(std::move(replacement))
     {
         assert(size_b > 0 && assoc > 0 && block_b > 0);
         assert((size_b % (assoc * block_b)) == 0);
 
         num_sets = size_b / (assoc * block_b);
-        sets.reserve(num_sets);
-        for (int i = 0; i < num_sets; i++)
-        {
-            sets.emplace_back(assoc);
-        }
+        valid_words = (assoc + 63) / 64;
+
+        pow2_geometry = (block_b & (block_b - 1)) == 0 && (num_sets & (num_sets - 1)) == 0;
+        block_shift = __builtin_ctz(static_cast<unsigned>(block_b));
+        set_shift = __builtin_ctz(static_cast<unsigned>(num_sets));
+        set_mask = static_cast<u32>(num_sets - 1);
+
+        const size_t ways = static_cast<size_t>(num_sets) * assoc;
+        lines = arena.take<CacheLine>(ways);
+        tags = arena.take<u32>(ways);
+        valid_mask = arena.take<u64>(static_cast<size_t>(num_sets) * valid_words);
     }
 
     // Main processor access method.
@@ -101,24 +187,28 @@ public:
     void access_processor_cache(bool is_write, u32 addr)
     {
         auto [set_idx, tag] = decode_address(addr);
-        CacheLine *cache_line = find_line(set_idx, tag);
+        int way = find_way(set_idx, tag);
+        const bool is_miss = way < 0;
+        CacheLine *cache_line;
 
-        if (cache_line == nullptr)
+        if (is_miss)
         {
             // Handle miss: need to allocate/evict.
-            Stats::incr_miss(curr_core);
-            CacheLine *victim = find_victim(set_idx);
+            stats.incr_miss(curr_core);
+            way = find_victim(set_idx);
+            CacheLine *victim = &line_at(set_idx, way);
 
-            // Check if victim needs writeback
-            if (victim->valid && victim->dirty)
+            // Check if victim needs writeback (or, with an exclusive hierarchy, moves to the level below).
+            if (victim->valid)
             {
-                bus.access_main_memory(curr_core, CYCLE_WRITEBACK_DIRTY);
+                bus.evict_block(curr_core, victim->addr, victim->dirty);
             }
 
             // Allocate the line for the current address.
             // We will also need to update the victim's state, but this can only be done within the processor_event (since it is protocol specific).
-            // LRU is updated later upon completion of the entire processor event.
-            victim->tag = tag;
+            // The replacement state is updated later upon completion of the entire processor event.
+            set_valid(set_idx, way, false); // Evicts the victim's block.
+            tags[static_cast<size_t>(set_idx) * assoc + way] = tag;
             victim->addr = addr;
             victim->valid = false; // To set valid flag only after fetch, attempting core to core transfer (only if have sharers) first.
             victim->dirty = false; // Reset dirty flag.
@@ -128,8 +218,9 @@ public:
         else
         {
             // Handle hit
-            Stats::incr_hit(curr_core);
-            Stats::add_exec_cycles(curr_core, CYCLE_HIT);
+            cache_line = &line_at(set_idx, way);
+            stats.incr_hit(curr_core);
+            stats.add_exec_cycles(curr_core, CYCLE_HIT);
         }
 
         // Run processor event:
@@ -137,40 +228,72 @@ public:
         bool is_shared = protocol->on_processor_event(processor_event, cache_line);
         if (is_shared)
         {
-            Stats::incr_shared_access(curr_core);
+            stats.incr_shared_access(curr_core);
         }
         else
         {
-            Stats::incr_private_access(curr_core);
+            stats.incr_private_access(curr_core);
         }
 
         if (!cache_line->valid && !is_shared)
         {
-            // Must fetch from main memory if not shared.
-            bus.access_main_memory(curr_core, CYCLE_MEM_BLOCK_FETCH);
+            // Must fetch from main memory (or the levels below the L1) if not shared.
+            bus.fetch_block(curr_core, cache_line);
+            stats.incr_memory_fetches();
             cache_line->valid = true;
         }
+        else if (is_miss)
+        {
+            bus.fill_block(curr_core, addr);
+        }
+        if (is_write)
+            bus.write_block(curr_core, addr);
 
         assert(cache_line->valid);
+        set_valid(set_idx, way, true);
 
-        // Assume that LRU time is updated on completion of the processor event.
-        cache_line->lru = Stats::get_exec_cycles(curr_core);
+        // Assume that the replacement state (e.g. LRU time) is updated on completion of the processor event.
+        if (is_miss)
+            replacement->on_fill(set_idx, way, stats.get_exec_cycles(curr_core));
+        else
+            replacement->on_hit(set_idx, way, stats.get_exec_cycles(curr_core));
 
         return;
     }
 
+    // back_invalidate drops the block of addr, evicted from an inclusive level below.
+    // Returns true if the cache held it, and sets dirty if the line was dirty.
+    bool back_invalidate(u32 addr, bool &dirty)
+    {
+        auto [set_idx, tag] = decode_address(addr);
+        int way = find_way(set_idx, tag);
+        if (way < 0)
+            return false;
+
+        CacheLine *line = &line_at(set_idx, way);
+        dirty = line->dirty;
+        line->valid = false;
+        line->dirty = false;
+        set_valid(set_idx, way, false);
+        return true;
+    }
+
     // Handle snoop bus transactions.
     // Returns true if shared (has valid cache line).
     bool trigger_snoop_event(int bus_transaction, u32 addr)
     {
         auto [set_idx, tag] = decode_address(addr);
-        CacheLine *line = find_line(set_idx, tag);
+        int way = find_way(set_idx, tag);
 
         // If invalid, no snoop processing required.
-        if (line == nullptr || !line->valid)
+        if (way < 0)
             return false;
 
+        CacheLine *line = &line_at(set_idx, way);
+        if (line->dirty)
+            bus.snoop_dirty();
         protocol->on_snoop_event(bus_transaction, line);
+        set_valid(set_idx, way, line->valid);
 
         return true;
     }
@@ -3,10 +3,16 @@
 #include <string>
 #include <iostream>
 #include <memory>
+#include <algorithm>
 #include "bus.cpp"
 #include "cache.hpp"
 #include "protocol_factory.hpp"
+#include "sim_config.hpp"
 #include "utils/trace_item.hpp"
+#include "utils/binary_trace.hpp"
+#include "utils/trace_stream.hpp"
+#include "utils/trace_loader.hpp"
+#include "utils/event_queue.hpp"
 #include "utils/stats.hpp"
 #include "utils/types.hpp"
 #include "utils/constants.hpp"
@@ -18,95 +24,211 @@ private:
     int words_per_block;
     int cache_size;
     int assoc;
+    int num_cores; // One per trace.
+
+    // Statistics of this simulation, shared by the bus, caches and protocols.
+    Stats stats;
     Bus bus;
 
-    std::vector<std::vector<TraceItem>> traces;
+    // Per-core trace cursors (fully loaded or streamed).
+    std::vector<TraceStream> traces;
 
+    // One allocation holding the lines and tag stores of all caches.
+    Arena arena;
     std::vector<std::unique_ptr<Cache>> caches;
-    std::vector<size_t> cur_idx;
 
-    // Finds the next core to process,
-    // auto advancing through compute operations.
-    // Returns -1 if no core is found.
-    int find_ready_memop_core()
+    // The next memory operation of each core (nullptr once its trace is finished).
+    std::vector<const TraceItem *> next_memop;
+
+    // Simulation kernel: every core with a memory operation left has an event at the
+    // cycle it is ready to issue it.
+    EventQueue<int> ready_cores;
+
+    // Advances core c to its next memory operation, adding the compute cycles
+    // folded in front of it (and of any compute-only items) to the core.
+    //
+    // Compute is accounted as soon as the previous memory operation completes.
+    void advance_to_memop(int c)
     {
-        int next_core = -1;
-        u64 next_time = UINT64_MAX;
-        for (int c = 0; c < NUM_OF_CORES; c++)
+        const TraceItem *trace_item = traces[c].peek();
+        while (trace_item != nullptr)
         {
-            auto max_idx = traces[c].size();
+            if (trace_item->gap() != 0)
+                stats.add_compute_cycles(c, trace_item->gap());
+            if (trace_item->op() != Operation::Other)
+                break;
+            traces[c].advance();
+            trace_item = traces[c].peek();
+        }
+        next_memop[c] = trace_item;
+    }
 
-            // Advance through compute operations (Operation::Other)
-            while (cur_idx[c] < max_idx && traces[c][cur_idx[c]].op == Operation::Other)
-            {
-                auto trace_item = traces[c][cur_idx[c]];
-                Stats::add_compute_cycles(c, trace_item.cycles);
-                cur_idx[c]++;
-            }
+    // schedule posts the next memory operation of core c, if its trace is not finished.
+    void schedule(int c)
+    {
+        if (next_memop[c] != nullptr)
+            ready_cores.push(stats.get_exec_cycles(c), c);
+    }
 
-            if (cur_idx[c] < max_idx && Stats::get_exec_cycles(c) < next_time)
+    // Finds the next core to process: the one ready first, ties broken by the smaller core.
+    // Returns -1 if no core is found.
+    //
+    // A core's clock can move while it is queued (a snoop may write a line back),
+    // so an event is only taken once its time matches the core's clock.
+    int next_ready_core()
+    {
+        while (!ready_cores.empty())
+        {
+            const auto &event = ready_cores.top();
+            const u64 now = stats.get_exec_cycles(event.payload);
+            if (event.time == now)
             {
-                next_time = Stats::get_exec_cycles(c);
-                next_core = c;
+                const int c = event.payload;
+                ready_cores.pop();
+                return c;
             }
+            ready_cores.reschedule_top(now);
         }
-        return next_core;
+        return -1;
     }
 
 public:
-    CacheSim(const std::string &protocol_name, int cache_size, int assoc, int block_size)
-        : block_bytes(block_size),
-          words_per_block(block_size / WORD_BYTES),
-          cache_size(cache_size),
-          assoc(assoc),
-          bus(caches, block_size)
+    CacheSim(const SimConfig &config, int num_cores)
+        : block_bytes(config.block_size),
+          words_per_block(config.block_size / WORD_BYTES),
+          cache_size(config.cache_size),
+          assoc(config.assoc),
+          num_cores(num_cores),
+          stats(config.cache_size, config.assoc, config.block_size, num_cores, config.protocol, config.replacement,
+                config.bus_slots, config.snoop_filter, config.migratory),
+          bus(caches, config, stats),
+          traces(num_cores),
+          arena(cache_arena_bytes(config.replacement, config.cache_size, config.assoc, config.block_size) * num_cores)
     {
         assert(block_bytes > 0 && (block_bytes % WORD_BYTES) == 0);
 
-        cur_idx.assign(NUM_OF_CORES, 0);
-        caches.reserve(NUM_OF_CORES);
-        for (int i = 0; i < NUM_OF_CORES; ++i)
+        caches.reserve(num_cores);
+        for (int i = 0; i < num_cores; ++i)
         {
-            caches.push_back(make_cache(protocol_name, cache_size, assoc, block_size, i, bus));
+            caches.push_back(make_cache(config.protocol, config.replacement, config.cache_size, config.assoc, config.block_size, i,
+                                        bus, stats, arena, config.update_threshold));
         }
     }
 
     void load_traces(const std::vector<std::string> &paths)
     {
-        if (paths.size() != NUM_OF_CORES)
+        if (paths.size() != static_cast<size_t>(num_cores))
         {
-            std::cerr << "need " << NUM_OF_CORES << " traces\n";
+            std::cerr << "need " << num_cores << " traces\n";
             std::exit(2);
         }
-        traces.resize(NUM_OF_CORES);
-        for (int c = 0; c < NUM_OF_CORES; c++)
+        // The traces are independent, so they are parsed concurrently.
+        auto items = load_traces_parallel(paths);
+        for (int c = 0; c < num_cores; c++)
         {
-            traces[c] = parse_trace(paths[c]);
+            traces[c].load(std::move(items[c]));
         }
     }
 
-    void run()
+    // share_traces is like load_traces, but reads already parsed traces without copying them.
+    // The traces must outlive the simulation.
+    void share_traces(const std::vector<std::vector<TraceItem>> &items)
     {
-        while (true)
+        if (items.size() != static_cast<size_t>(num_cores))
+        {
+            std::cerr << "need " << num_cores << " traces\n";
+            std::exit(2);
+        }
+        for (int c = 0; c < num_cores; c++)
+        {
+            traces[c].view(items[c]);
+        }
+    }
+
+    // share_streams reads the traces from decoders shared with other simulations.
+    void share_streams(const std::vector<std::unique_ptr<SharedTrace>> &src)
+    {
+        if (src.size() != static_cast<size_t>(num_cores))
+        {
+            std::cerr << "need " << num_cores << " traces\n";
+            std::exit(2);
+        }
+        for (int c = 0; c < num_cores; c++)
+        {
+            traces[c].share(*src[c]);
+        }
+    }
+
+    // stream_traces is like load_traces, but each trace is read in fixed-size chunks
+    // by a background reader thread while the simulation runs, so memory stays
+    // constant regardless of the trace length.
+    void stream_traces(const std::vector<std::string> &paths)
+    {
+        if (paths.size() != static_cast<size_t>(num_cores))
+        {
+            std::cerr << "need " << num_cores << " traces\n";
+            std::exit(2);
+        }
+        for (int c = 0; c < num_cores; c++)
+        {
+            traces[c].stream(paths[c]);
+        }
+    }
+
+    const Stats &get_stats() const { return stats; }
+
+    // start moves every core to its first memory operation.
+    void start()
+    {
+        next_memop.assign(num_cores, nullptr);
+        ready_cores.clear();
+        for (int c = 0; c < num_cores; c++)
+        {
+            advance_to_memop(c);
+            schedule(c);
+        }
+    }
+
+    // step processes up to max_ops memory operations.
+    // Returns false once every trace is finished.
+    bool step(u64 max_ops)
+    {
+        for (u64 n = 0; n < max_ops; n++)
         {
             // Find next core with memory operation to process:
-            const int curr_core = find_ready_memop_core();
+            const int curr_core = next_ready_core();
             if (curr_core < 0)
-                break;
+                return false;
+
+            // Every bus request starts at the clock of the requesting (or snooped) core, the
+            // running cores are taken in clock order and clocks only move forward, so the
+            // cycles before the requester's clock are done. Finished cores still write back
+            // lines when snooped, their requests then start at the requester's clock.
+            bus.retire_before(stats.get_exec_cycles(curr_core));
 
             // Process memory operation:
-            TraceItem trace_item = traces[curr_core][cur_idx[curr_core]];
-            if (trace_item.op == Operation::Load)
-                Stats::incr_load(curr_core);
-            else if (trace_item.op == Operation::Store)
-                Stats::incr_store(curr_core);
+            const TraceItem &trace_item = *next_memop[curr_core];
+            const bool is_store = trace_item.op() == Operation::Store;
+            if (is_store)
+                stats.incr_store(curr_core);
+            else
+                stats.incr_load(curr_core);
 
             // Access cache:
-            caches[curr_core]->access_processor_cache(
-                trace_item.op == Operation::Store,
-                trace_item.addr);
+            caches[curr_core]->access_processor_cache(is_store, trace_item.addr);
 
-            cur_idx[curr_core]++;
+            traces[curr_core].advance();
+            advance_to_memop(curr_core);
+            schedule(curr_core);
+        }
+        return true;
+    }
+
+    void run()
+    {
+        start();
+        while (step(UINT64_MAX))
+        {
         }
     }
 };
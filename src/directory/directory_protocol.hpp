@@ -0,0 +1,135 @@
+#pragma once
+#include "../coherence_protocol.hpp"
+#include "../utils/stats.hpp"
+
+// DirectoryProtocol is MESI over a point-to-point network with a full-map home directory,
+// instead of a broadcast bus. Misses and upgrades are sent to the block's home node,
+// which forwards them to the caches holding the block (see Bus::directory_request).
+class DirectoryProtocol : public CoherenceProtocol
+{
+private:
+    int curr_core;
+    int block_bytes;
+    Bus &bus;
+    Stats &stats;
+
+    enum DirState
+    {
+        M,
+        E,
+        S,
+        I,
+    };
+
+    enum DirPrEvent
+    {
+        PrWr,
+        PrRd,
+    };
+
+    // Messages forwarded by the home node.
+    enum DirMsg
+    {
+        Inv,     // Invalidate (and send the data to the requester, if asked).
+        FwdGetS, // Send the data to the requester and keep a shared copy.
+    };
+
+public:
+    DirectoryProtocol(int curr_core, int block_bytes, Bus &bus, Stats &stats)
+        : curr_core(curr_core),
+          block_bytes(block_bytes),
+          bus(bus),
+          stats(stats) {};
+
+    int parse_processor_event(bool is_write, CacheLine *cache_line)
+    {
+        (void)cache_line; // Unused parameter.
+        return is_write ? DirPrEvent::PrWr : DirPrEvent::PrRd;
+    }
+
+    bool on_processor_event(int processor_event, CacheLine *cache_line) override
+    {
+        // Set default state if invalid.
+        if (!cache_line->valid)
+            cache_line->state = DirState::I;
+
+        bool is_shared = false;
+        switch (cache_line->state)
+        {
+        case DirState::M:
+            break;
+
+        case DirState::E:
+            switch (processor_event)
+            {
+            case DirPrEvent::PrWr:
+                // The directory records E and M alike (exclusive owner), so this is silent.
+                cache_line->state = DirState::M;
+                cache_line->dirty = true;
+                break;
+            }
+            break;
+
+        case DirState::S:
+            is_shared = true;
+            switch (processor_event)
+            {
+            case DirPrEvent::PrWr:
+                // Upgrade: the home node invalidates the other sharers, no data is needed.
+                is_shared = bus.directory_request(curr_core, DirMsg::Inv, true, cache_line, false);
+                stats.incr_bus_invalidations();
+                cache_line->state = DirState::M;
+                cache_line->dirty = true;
+                break;
+            }
+            break;
+
+        case DirState::I:
+            switch (processor_event)
+            {
+            case DirPrEvent::PrRd:
+                is_shared = bus.directory_request(curr_core, DirMsg::FwdGetS, false, cache_line, true);
+                cache_line->state = is_shared ? DirState::S : DirState::E;
+                break;
+            case DirPrEvent::PrWr:
+                is_shared = bus.directory_request(curr_core, DirMsg::Inv, true, cache_line, true);
+                stats.incr_bus_invalidations();
+                cache_line->state = DirState::M;
+                cache_line->dirty = true;
+                break;
+            }
+            break;
+
+        default:
+            std::cerr << "Invalid Directory state\n";
+            break;
+        }
+
+        return is_shared;
+    }
+
+    void on_snoop_event(int message, CacheLine *cache_line) override
+    {
+        // If invalid, no processing required.
+        if (cache_line == nullptr || !cache_line->valid)
+            return;
+
+        switch (message)
+        {
+        case DirMsg::FwdGetS:
+            if (cache_line->state == DirState::M)
+            {
+                // The owner also sends the dirty data back to the home node's memory.
+                bus.access_main_memory(curr_core, CYCLE_WRITEBACK_DIRTY);
+                cache_line->dirty = false;
+            }
+            cache_line->state = DirState::S;
+            break;
+        case DirMsg::Inv:
+            cache_line->dirty = false;
+            cache_line->valid = false;
+            cache_line->state = DirState::I;
+            break;
+        }
+    }
+};
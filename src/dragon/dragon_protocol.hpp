@@ -9,6 +9,7 @@ private:
     int curr_core;
     int block_bytes;
     Bus &bus;
+    Stats &stats;
 
     enum DragonState
     {
@@ -33,10 +34,11 @@ private:
     };
 
 public:
-    DragonProtocol(int curr_core, int block_bytes, Bus &bus)
+    DragonProtocol(int curr_core, int block_bytes, Bus &bus, Stats &stats)
         : curr_core(curr_core),
           block_bytes(block_bytes),
-          bus(bus) {};
+          bus(bus),
+          stats(stats) {};
 
     int parse_processor_event(bool is_write, CacheLine *cache_line) override
     {
@@ -69,7 +71,7 @@ public:
 
             // Processor writes misses also trigger a bus update (sends a word from one cache to another).
             is_shared = bus.trigger_bus_broadcast(curr_core, DragonBusTxn::BusUpd, cache_line, 1);
-            Stats::incr_bus_updates();
+            stats.incr_bus_updates();
             break;
         }
 
@@ -94,7 +96,7 @@ public:
             case DragonPrEvent::PrWr:
                 // BusUpd sends a word from one cache to another.
                 is_shared = bus.trigger_bus_broadcast(curr_core, DragonBusTxn::BusUpd, cache_line, 1);
-                Stats::incr_bus_updates();
+                stats.incr_bus_updates();
                 cache_line->state = is_shared ? DragonState::Sm : DragonState::M;
                 cache_line->dirty = true;
                 break;
@@ -108,7 +110,7 @@ public:
             case DragonPrEvent::PrWr:
                 // BusUpd sends a word from one cache to another.
                 is_shared = bus.trigger_bus_broadcast(curr_core, DragonBusTxn::BusUpd, cache_line, 1);
-                Stats::incr_bus_updates();
+                stats.incr_bus_updates();
                 cache_line->state = is_shared ? DragonState::Sm : DragonState::M;
                 cache_line->dirty = true;
                 break;
@@ -0,0 +1,147 @@
+// cache_level.hpp contains the tag store of a cache level below the L1s.
+#pragma once
+#include <utility>
+#include "../utils/types.hpp"
+#include "../utils/arena.hpp"
+#include "../replacement/lru_policy.hpp"
+
+// CacheLevel is a set-associative tag store with LRU replacement, for the levels of the
+// memory hierarchy below the coherent L1s (see MemoryHierarchy). It records which blocks
+// (block address / block size) it holds and whether they are dirty, but no coherence state.
+class CacheLevel
+{
+private:
+    static constexpr u8 VALID = 1;
+    static constexpr u8 DIRTY = 2;
+
+    int assoc;
+    u32 num_sets;
+    bool pow2_sets; // Sets and tags are then decoded with a mask and a shift.
+    u32 set_mask;
+    int set_shift;
+    Arena arena;
+    u32 *tags; // Indexed by set * assoc + way.
+    u8 *flags; // VALID and DIRTY bits, indexed by set * assoc + way.
+    LRUPolicy lru;
+
+    // decode returns the set and the tag of block.
+    std::pair<u32, u32> decode(u32 block) const
+    {
+        if (pow2_sets)
+            return {block & set_mask, block >> set_shift};
+        return {block % num_sets, block / num_sets};
+    }
+
+    // find returns the way of the set holding block, or -1 if not found.
+    int find(u32 set, u32 tag) const
+    {
+        for (int w = 0; w < assoc; w++)
+        {
+            const size_t i = static_cast<size_t>(set) * assoc + w;
+            if ((flags[i] & VALID) && tags[i] == tag)
+                return w;
+        }
+        return -1;
+    }
+
+public:
+    // Eviction is the block displaced by a fill, if any.
+    struct Eviction
+    {
+        bool valid = false;
+        u32 block = 0;
+        bool dirty = false;
+    };
+
+    static size_t arena_bytes(int num_sets, int assoc)
+    {
+        const size_t ways = static_cast<size_t>(num_sets) * assoc;
+        return Arena::bytes_for<u32>(ways) + Arena::bytes_for<u8>(ways) + LRUPolicy::arena_bytes(num_sets, assoc);
+    }
+
+    CacheLevel(int size_bytes, int assoc, int block_bytes)
+        : assoc(assoc),
+          num_sets(static_cast<u32>(size_bytes / (assoc * block_bytes))),
+          pow2_sets((num_sets & (num_sets - 1)) == 0),
+          set_mask(num_sets - 1),
+          set_shift(__builtin_ctz(num_sets)),
+          arena(arena_bytes(num_sets, assoc)),
+          tags(arena.take<u32>(static_cast<size_t>(num_sets) * assoc)),
+          flags(arena.take<u8>(static_cast<size_t>(num_sets) * assoc)),
+          lru(num_sets, assoc, arena) {}
+
+    bool contains(u32 block) const
+    {
+        const auto [set, tag] = decode(block);
+        return find(set, tag) >= 0;
+    }
+
+    // access returns true if block is present, and then updates its replacement state.
+    bool access(u32 block, u64 now)
+    {
+        const auto [set, tag] = decode(block);
+        const int way = find(set, tag);
+        if (way < 0)
+            return false;
+        lru.on_hit(set, way, now);
+        return true;
+    }
+
+    // insert fills the absent block, and returns the block it evicted.
+    Eviction insert(u32 block, bool dirty, u64 now)
+    {
+        const auto [set, tag] = decode(block);
+        int way = -1;
+        for (int w = 0; w < assoc && way < 0; w++)
+            if (!(flags[static_cast<size_t>(set) * assoc + w] & VALID))
+                way = w;
+        if (way < 0)
+            way = lru.victim(set);
+
+        const size_t i = static_cast<size_t>(set) * assoc + way;
+        Eviction evicted;
+        if (flags[i] & VALID)
+            evicted = {true, tags[i] * num_sets + set, (flags[i] & DIRTY) != 0};
+        tags[i] = tag;
+        flags[i] = VALID | (dirty ? DIRTY : 0);
+        lru.on_fill(set, way, now);
+        return evicted;
+    }
+
+    // mark_dirty sets the dirty bit of block, and returns false if it is absent.
+    bool mark_dirty(u32 block)
+    {
+        const auto [set, tag] = decode(block);
+        const int way = find(set, tag);
+        if (way < 0)
+            return false;
+        flags[static_cast<size_t>(set) * assoc + way] |= DIRTY;
+        return true;
+    }
+
+    // clean clears the dirty bit of block, and returns true if it was set.
+    bool clean(u32 block)
+    {
+        const auto [set, tag] = decode(block);
+        const int way = find(set, tag);
+        if (way < 0)
+            return false;
+        u8 &f = flags[static_cast<size_t>(set) * assoc + way];
+        const bool dirty = (f & DIRTY) != 0;
+        f &= ~DIRTY;
+        return dirty;
+    }
+
+    // remove drops block, and returns true if it was dirty.
+    bool remove(u32 block)
+    {
+        const auto [set, tag] = decode(block);
+        const int way = find(set, tag);
+        if (way < 0)
+            return false;
+        u8 &f = flags[static_cast<size_t>(set) * assoc + way];
+        const bool dirty = (f & DIRTY) != 0;
+        f = 0;
+        return dirty;
+    }
+};
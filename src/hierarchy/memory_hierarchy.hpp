@@ -0,0 +1,335 @@
+// memory_hierarchy.hpp contains the cache levels between the coherent L1s and main memory.
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <functional>
+#include "cache_level.hpp"
+#include "../utils/stats.hpp"
+#include "../utils/constants.hpp"
+
+// Inclusion policies accepted by HierarchyConfig.
+static const std::vector<std::string> INCLUSION_POLICIES = {"inclusive", "non-inclusive", "exclusive"};
+
+// HierarchyConfig describes the cache levels below the L1s (none by default).
+struct HierarchyConfig
+{
+    int l2_size = 0; // Private L2 of each core, 0 for none.
+    int l2_assoc = 1;
+    int llc_size = 0; // Shared LLC, 0 for none. Its blocks are interleaved over llc_banks banks.
+    int llc_assoc = 1;
+    int llc_banks = 1;
+    std::string inclusion = DEFAULT_INCLUSION;
+
+    bool enabled() const { return l2_size > 0 || llc_size > 0; }
+};
+
+// HierarchyCost is the latency of a hierarchy operation for the requesting core.
+struct HierarchyCost
+{
+    u64 private_cycles = 0;    // Cycles in the core's private L2.
+    u64 shared_cycles = 0;     // Cycles in the LLC and main memory, reached over the bus.
+    int memory_writebacks = 0; // Dirty blocks evicted to main memory.
+    bool dirty = false;        // The fetched block was dirty (moved up from an exclusive level).
+};
+
+// MemoryHierarchy models an optional private L2 per core and an optional shared, banked LLC
+// below the L1s. Coherence is kept among the L1s only: the lower levels hold blocks (with
+// LRU replacement) but no coherence state, and are only looked up when an L1 miss is not
+// served cache-to-cache. The L2s are kept coherent with the L1s' writes: a write drops the
+// other cores' L2 copies, and a miss first flushes the dirty copy another core's L2 may hold.
+//
+// Inclusion policies:
+// - inclusive: misses fill every level. A block evicted from the L2 is back-invalidated in the
+//   core's L1, and a block evicted from the LLC in every L2 and L1. Blocks the L1s receive
+//   cache-to-cache are also filled into the lower levels.
+// - non-inclusive: misses fill every level, and evictions never back-invalidate.
+// - exclusive: a block is in at most one level of a core. Misses fill the L1 only, hits move
+//   the block up, and the victims of each level (clean or dirty) move one level down. Blocks
+//   the L1s receive cache-to-cache are dropped from the core's L2 and from the LLC.
+class MemoryHierarchy
+{
+public:
+    // InvalidateL1 back-invalidates block in core's L1. Returns true if it was held,
+    // and sets dirty if it was dirty.
+    using InvalidateL1 = std::function<bool(int core, u32 block, bool &dirty)>;
+
+private:
+    bool inclusive;
+    bool exclusive;
+    int num_cores;
+    Stats &stats;
+    InvalidateL1 invalidate_l1;
+
+    std::vector<std::unique_ptr<CacheLevel>> l2;  // One per core, empty without an L2.
+    std::vector<std::unique_ptr<CacheLevel>> llc; // One per bank, empty without an LLC.
+    int l2_level = -1;                            // Index of the levels in stats.
+    int llc_level = -1;
+
+    // L2Copies counts the copies, over all the L2s, of the blocks hashed to one entry.
+    struct L2Copies
+    {
+        u32 count = 0;
+        u32 core_sum = 0; // Sum of the cores holding them, i.e. the core holding a single copy.
+    };
+    std::vector<L2Copies> l2_copies;
+    int l2_copies_shift = 32;
+
+    u32 bank_of(u32 block) const { return block % llc.size(); }
+
+    // copies returns the entry of block, which it shares with the blocks of the same hash.
+    L2Copies &copies(u32 block) { return l2_copies[(block * 0x9E3779B1u) >> l2_copies_shift]; }
+
+    // count_l2_copy counts (delta 1) or uncounts (delta -1) a copy of block in core's L2.
+    void count_l2_copy(int core, u32 block, int delta)
+    {
+        L2Copies &e = copies(block);
+        e.count += delta;
+        e.core_sum += delta * core;
+    }
+
+    // no_other_l2_copy returns true if no L2 but core's may hold block, without looking
+    // the L2s up (the blocks sharing its entry may make it return false anyway).
+    bool no_other_l2_copy(int core, u32 block)
+    {
+        const L2Copies &e = copies(block);
+        return e.count == 0 || (e.count == 1 && e.core_sum == static_cast<u32>(core));
+    }
+
+    // remove_l2 drops block from core's L2, which holds it. Returns true if it was dirty.
+    bool remove_l2(int core, u32 block)
+    {
+        count_l2_copy(core, block, -1);
+        return l2[core]->remove(block);
+    }
+
+    // back_invalidate_all drops block from every L2 and L1, and returns true if a copy was dirty.
+    bool back_invalidate_all(u32 block)
+    {
+        bool dirty = false;
+        for (int c = 0; c < num_cores; c++)
+        {
+            if (!l2.empty() && l2[c]->contains(block))
+            {
+                dirty = remove_l2(c, block) || dirty;
+                stats.level(llc_level).back_invalidations++;
+            }
+            bool l1_dirty = false;
+            if (invalidate_l1(c, block, l1_dirty))
+            {
+                dirty = dirty || l1_dirty;
+                stats.level(llc_level).back_invalidations++;
+            }
+        }
+        return dirty;
+    }
+
+    // flush_remote_l2 writes the dirty copy of block another core's L2 holds (the core wrote the
+    // block and its L1 evicted it) to the LLC, before core's miss looks the block up there.
+    void flush_remote_l2(int core, u32 block, u64 now, HierarchyCost &cost)
+    {
+        if (no_other_l2_copy(core, block))
+            return;
+        for (int c = 0; c < num_cores; c++)
+        {
+            if (c == core || !l2[c]->clean(block))
+                continue;
+            stats.level(l2_level).remote_flushes++;
+            cost.shared_cycles += CYCLE_L2_HIT;
+            write_llc(block, true, now, cost);
+            return; // Only the last writer holds it dirty.
+        }
+    }
+
+    void insert_llc(u32 block, bool dirty, u64 now, HierarchyCost &cost)
+    {
+        auto evicted = llc[bank_of(block)]->insert(block, dirty, now);
+        if (!evicted.valid)
+            return;
+        if (inclusive)
+            evicted.dirty = back_invalidate_all(evicted.block) || evicted.dirty;
+        if (evicted.dirty)
+        {
+            stats.level(llc_level).writebacks++;
+            cost.memory_writebacks++;
+        }
+    }
+
+    // write_llc writes a block evicted from a level above into the LLC (or main memory).
+    void write_llc(u32 block, bool dirty, u64 now, HierarchyCost &cost)
+    {
+        if (llc.empty())
+        {
+            cost.memory_writebacks += dirty;
+            return;
+        }
+        cost.shared_cycles += CYCLE_LLC_HIT;
+        if (!llc[bank_of(block)]->contains(block))
+            insert_llc(block, dirty, now, cost);
+        else if (dirty)
+            llc[bank_of(block)]->mark_dirty(block);
+    }
+
+    void insert_l2(int core, u32 block, bool dirty, u64 now, HierarchyCost &cost)
+    {
+        auto evicted = l2[core]->insert(block, dirty, now);
+        count_l2_copy(core, block, 1);
+        if (!evicted.valid)
+            return;
+        count_l2_copy(core, evicted.block, -1);
+        bool l1_dirty = false;
+        if (inclusive && invalidate_l1(core, evicted.block, l1_dirty))
+        {
+            evicted.dirty = evicted.dirty || l1_dirty;
+            stats.level(l2_level).back_invalidations++;
+        }
+        // Exclusive: every victim moves down, otherwise only dirty ones are written back.
+        if (evicted.dirty)
+            stats.level(l2_level).writebacks++;
+        if (exclusive || evicted.dirty)
+            write_llc(evicted.block, evicted.dirty, now, cost);
+    }
+
+public:
+    MemoryHierarchy(const HierarchyConfig &config, int block_bytes, Stats &stats, InvalidateL1 invalidate_l1)
+        : inclusive(config.inclusion == "inclusive"),
+          exclusive(config.inclusion == "exclusive"),
+          num_cores(stats.num_cores()),
+          stats(stats),
+          invalidate_l1(std::move(invalidate_l1))
+    {
+        if (config.l2_size > 0)
+        {
+            for (int c = 0; c < num_cores; c++)
+                l2.push_back(std::make_unique<CacheLevel>(config.l2_size, config.l2_assoc, block_bytes));
+            l2_level = stats.add_level("L2", 1, config.inclusion);
+            // Four times as many entries as L2 lines (a power of two), so that few blocks share one.
+            size_t entries = 1;
+            for (l2_copies_shift = 32; entries < 4 * static_cast<size_t>(num_cores) * (config.l2_size / block_bytes); l2_copies_shift--)
+                entries *= 2;
+            l2_copies.resize(entries);
+        }
+        if (config.llc_size > 0)
+        {
+            for (int b = 0; b < config.llc_banks; b++)
+                llc.push_back(std::make_unique<CacheLevel>(config.llc_size / config.llc_banks, config.llc_assoc, block_bytes));
+            llc_level = stats.add_level("LLC", config.llc_banks, config.inclusion);
+        }
+    }
+
+    // fetch looks up block for an L1 miss of core, from the L2 down to main memory.
+    HierarchyCost fetch(int core, u32 block, u64 now)
+    {
+        HierarchyCost cost;
+        if (!l2.empty())
+        {
+            LevelStats &s = stats.level(l2_level);
+            s.accesses++;
+            cost.private_cycles += CYCLE_L2_HIT;
+            if (l2[core]->access(block, now))
+            {
+                s.hits++;
+                s.latency_cycles += CYCLE_L2_HIT;
+                if (exclusive)
+                    cost.dirty = remove_l2(core, block);
+                return cost;
+            }
+            s.misses++;
+            flush_remote_l2(core, block, now, cost);
+        }
+
+        if (!llc.empty())
+        {
+            LevelStats &s = stats.level(llc_level);
+            s.accesses++;
+            s.bank_accesses[bank_of(block)]++;
+            cost.shared_cycles += CYCLE_LLC_HIT;
+            if (llc[bank_of(block)]->access(block, now))
+            {
+                s.hits++;
+                if (exclusive)
+                    cost.dirty = llc[bank_of(block)]->remove(block);
+            }
+            else
+            {
+                s.misses++;
+                cost.shared_cycles += CYCLE_MEM_BLOCK_FETCH;
+            }
+            s.latency_cycles += cost.shared_cycles;
+        }
+        else
+        {
+            cost.shared_cycles += CYCLE_MEM_BLOCK_FETCH;
+        }
+
+        if (!l2.empty())
+            stats.level(l2_level).latency_cycles += cost.private_cycles + cost.shared_cycles;
+        if (!exclusive)
+        {
+            if (!llc.empty() && !llc[bank_of(block)]->contains(block))
+                insert_llc(block, false, now, cost);
+            if (!l2.empty())
+                insert_l2(core, block, false, now, cost);
+        }
+        return cost;
+    }
+
+    // evict handles a block evicted from core's L1.
+    HierarchyCost evict(int core, u32 block, bool dirty, u64 now)
+    {
+        HierarchyCost cost;
+        if (!exclusive && !dirty)
+            return cost;
+        if (l2.empty())
+        {
+            write_llc(block, dirty, now, cost);
+            return cost;
+        }
+        cost.private_cycles += CYCLE_L2_HIT;
+        if (!l2[core]->contains(block))
+            insert_l2(core, block, dirty, now, cost);
+        else if (dirty)
+            l2[core]->mark_dirty(block);
+        return cost;
+    }
+
+    // write drops block from the other cores' L2s, as core's L1 wrote it. Their L1 copies were
+    // invalidated (or, under an update protocol, updated), so their L2 copies are stale. A dirty
+    // copy is dropped too, since core's L1 holds the newer block.
+    void write(int core, u32 block)
+    {
+        if (l2.empty() || no_other_l2_copy(core, block))
+            return;
+        for (int c = 0; c < num_cores; c++)
+        {
+            if (c != core && l2[c]->contains(block))
+            {
+                remove_l2(c, block);
+                stats.level(l2_level).coherence_invalidations++;
+            }
+        }
+    }
+
+    // fill handles a block core's L1 received cache-to-cache, which an inclusive
+    // hierarchy also holds below, and an exclusive one no longer holds below.
+    HierarchyCost fill(int core, u32 block, u64 now)
+    {
+        HierarchyCost cost;
+        if (exclusive)
+        {
+            // The other cache sent the current block, so older copies are dropped clean.
+            if (!l2.empty() && l2[core]->contains(block))
+                remove_l2(core, block);
+            if (!llc.empty())
+                llc[bank_of(block)]->remove(block);
+            return cost;
+        }
+        if (!inclusive)
+            return cost;
+        if (!llc.empty() && !llc[bank_of(block)]->contains(block))
+            insert_llc(block, false, now, cost);
+        if (!l2.empty() && !l2[core]->contains(block))
+            insert_l2(core, block, false, now, cost);
+        return cost;
+    }
+};
@@ -0,0 +1,178 @@
+#pragma once
+#include "../coherence_protocol.hpp"
+#include "../utils/stats.hpp"
+
+// HybridProtocol is a competitive update protocol: Dragon's update states, where each cache
+// counts the updates a line receives without a local access, and self-invalidates the line
+// after update_threshold of them (0: never).
+//
+// With a threshold of 0, the transitions are Dragon's, write misses included (their word is
+// broadcast even without other holders). The results still differ from Dragon's with more than
+// two cores, since Dragon's broadcasts (Bus::trigger_bus_broadcast) stop at the first cache
+// holding the block: the other holders miss the BusRd or BusUpd, and may stay in E, M or Sm.
+// With two cores, both give the same results (scripts/run_tests.sh checks it on blackscholes).
+//
+// A producer-consumer block keeps being updated, since the consumers read every update.
+// A migratory block ends up in one cache only, so its writes no longer go on the bus, as under
+// an invalidation protocol. Every cache holding the block is snooped (see Bus::trigger_bus_forward),
+// so the writer sees whether sharers remain after the update.
+class HybridProtocol : public CoherenceProtocol
+{
+private:
+    int curr_core;
+    int block_bytes;
+    int update_threshold;
+    Bus &bus;
+    Stats &stats;
+
+    enum HybridState
+    {
+        E,
+        Sc,
+        Sm,
+        M,
+    };
+
+    enum HybridPrEvent
+    {
+        PrRd,
+        PrRdMiss,
+        PrWr,
+        PrWrMiss,
+    };
+
+    enum HybridBusTxn
+    {
+        BusRd,
+        BusUpd, // BusUpd causes bus updates sent over the bus.
+    };
+
+    u32 block_of(const CacheLine *cache_line) const { return cache_line->addr - cache_line->addr % block_bytes; }
+
+    // Sends a BusUpd for a write, and returns true if other caches still hold the line.
+    bool update(CacheLine *cache_line)
+    {
+        // BusUpd sends a word from one cache to another.
+        bus.trigger_bus_forward(curr_core, HybridBusTxn::BusUpd, cache_line, 1);
+        stats.incr_bus_updates();
+        stats.record_hybrid_write(block_of(cache_line), true);
+        return bus.has_other_holders(curr_core, cache_line);
+    }
+
+public:
+    HybridProtocol(int curr_core, int block_bytes, int update_threshold, Bus &bus, Stats &stats)
+        : curr_core(curr_core),
+          block_bytes(block_bytes),
+          update_threshold(update_threshold),
+          bus(bus),
+          stats(stats) {};
+
+    int parse_processor_event(bool is_write, CacheLine *cache_line) override
+    {
+        if (is_write)
+        {
+            return (cache_line == nullptr || !cache_line->valid) ? HybridPrEvent::PrWrMiss : HybridPrEvent::PrWr;
+        }
+        else
+        {
+            return (cache_line == nullptr || !cache_line->valid) ? HybridPrEvent::PrRdMiss : HybridPrEvent::PrRd;
+        }
+    }
+
+    bool on_processor_event(int processor_event, CacheLine *cache_line) override
+    {
+        // A local access consumes the updates received since the previous one.
+        if (cache_line->valid && cache_line->counter > 0)
+            stats.record_useful_update(block_of(cache_line));
+        cache_line->counter = 0;
+
+        // Handle all cache miss process events here (this sets the default state).
+        bool is_shared = false;
+        switch (processor_event)
+        {
+        case HybridPrEvent::PrRdMiss:
+            is_shared = bus.trigger_bus_forward(curr_core, HybridBusTxn::BusRd, cache_line, block_bytes / WORD_BYTES);
+            cache_line->state = is_shared ? HybridState::Sc : HybridState::E;
+            return is_shared;
+
+        case HybridPrEvent::PrWrMiss:
+            is_shared = bus.trigger_bus_forward(curr_core, HybridBusTxn::BusRd, cache_line, block_bytes / WORD_BYTES);
+            cache_line->dirty = true;
+            // Processor writes misses also trigger a bus update (sends a word from one cache to another).
+            // Unlike Dragon, the state is decided after the update, since the sharers may drop the
+            // block on it (with a threshold of 0, they never do: the BusRd result then decides).
+            cache_line->state = update(cache_line) ? HybridState::Sm : HybridState::M;
+            return is_shared;
+        }
+
+        // Handle cache hit processor events here:
+        // Skip PrRd entirely as these do not affect the state.
+        switch (cache_line->state)
+        {
+        case HybridState::E:
+        case HybridState::M:
+            if (processor_event == HybridPrEvent::PrWr)
+            {
+                stats.record_hybrid_write(block_of(cache_line), false);
+                cache_line->state = HybridState::M;
+                cache_line->dirty = true;
+            }
+            break;
+
+        case HybridState::Sc:
+        case HybridState::Sm:
+            is_shared = true;
+            if (processor_event == HybridPrEvent::PrWr)
+            {
+                // The sharers that stopped reading the block drop it, so the writer may become exclusive.
+                is_shared = update(cache_line);
+                cache_line->state = is_shared ? HybridState::Sm : HybridState::M;
+                cache_line->dirty = true;
+            }
+            break;
+
+        default:
+            std::cerr << "Invalid Hybrid state\n";
+            break;
+        }
+
+        return is_shared;
+    }
+
+    void on_snoop_event(int bus_transaction, CacheLine *cache_line) override
+    {
+        // If invalid, no snoop processing required.
+        if (cache_line == nullptr || !cache_line->valid)
+            return;
+
+        // Every holder answers: with the block on a BusRd, by taking the word on a BusUpd.
+        bus.supply_data();
+        switch (bus_transaction)
+        {
+        case HybridBusTxn::BusRd:
+            if (cache_line->state == HybridState::E)
+                cache_line->state = HybridState::Sc;
+            else if (cache_line->state == HybridState::M)
+            {
+                cache_line->state = HybridState::Sm;
+                cache_line->dirty = false; // Data flushed via cache-to-cache transfer.
+            }
+            break;
+
+        case HybridBusTxn::BusUpd:
+            stats.record_update_received(block_of(cache_line));
+            // The writer owns the block from now on.
+            cache_line->state = HybridState::Sc;
+            cache_line->dirty = false;
+            if (cache_line->counter < UINT16_MAX)
+                cache_line->counter++;
+            if (update_threshold > 0 && cache_line->counter >= update_threshold)
+            {
+                stats.incr_self_invalidations();
+                cache_line->counter = 0;
+                cache_line->valid = false;
+            }
+            break;
+        }
+    }
+};
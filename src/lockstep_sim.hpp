@@ -0,0 +1,77 @@
+// lockstep_sim.hpp contains the driver that simulates several cache configurations
+// from a single pass over the traces.
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include "cache_sim.hpp"
+#include "sim_config.hpp"
+#include "utils/trace_stream.hpp"
+#include "utils/types.hpp"
+#include "utils/constants.hpp"
+
+// -------------------
+// Lockstep configuration
+// -------------------
+static constexpr u64 LOCKSTEP_SLICE_OPS = 1 << 18; // Memory operations a simulation runs before yielding to the next one.
+
+// LockstepSim runs independent simulations (cache, bus and protocol stacks) over one
+// shared decode of the traces.
+//
+// Every simulation keeps its own position in each trace, since the cores interleave
+// differently in every configuration. The simulations take turns of LOCKSTEP_SLICE_OPS
+// memory operations, so they usually stay close together in the traces: each chunk is
+// decoded once, read by every simulation while it is still in the host caches, then freed.
+// Nothing bounds how far apart they drift (a simulation may run ahead on one trace and
+// behind on another, so making the leaders wait could deadlock): the chunks between the
+// slowest and the fastest simulation of a trace stay in memory.
+class LockstepSim
+{
+private:
+    std::vector<std::unique_ptr<SharedTrace>> traces;
+    std::vector<std::unique_ptr<CacheSim>> sims;
+
+public:
+    LockstepSim(const std::vector<SimConfig> &configs, const std::vector<std::string> &paths)
+    {
+        if (paths.empty())
+        {
+            std::cerr << "need at least one trace\n";
+            std::exit(2);
+        }
+        for (const auto &path : paths)
+        {
+            traces.push_back(std::make_unique<SharedTrace>(path, configs.size()));
+        }
+        for (const auto &config : configs)
+        {
+            sims.push_back(std::make_unique<CacheSim>(config, static_cast<int>(paths.size())));
+            sims.back()->share_streams(traces);
+        }
+    }
+
+    void run()
+    {
+        for (auto &sim : sims)
+        {
+            sim->start();
+        }
+
+        std::vector<bool> running(sims.size(), true);
+        size_t remaining = sims.size();
+        while (remaining > 0)
+        {
+            for (size_t i = 0; i < sims.size(); i++)
+            {
+                if (running[i] && !sims[i]->step(LOCKSTEP_SLICE_OPS))
+                {
+                    running[i] = false;
+                    remaining--;
+                }
+            }
+        }
+    }
+
+    size_t size() const { return sims.size(); }
+    const Stats &get_stats(size_t i) const { return sims[i]->get_stats(); }
+};
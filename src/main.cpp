@@ -1,64 +1,260 @@
 // CS4223 cache coherence simulator entrypoint.
 //
 // CLI
-//   ./coherence <protocol> <input_base_or_any_0.data> <cache_size> <associativity> <block_size> [--json]
+//   ./coherence <protocol> <input_base_or_any_0.data> <cache_size> <associativity> <block_size> [--json] [--stream] [--replacement <policy>] [--bus-slots <n>] [--cores <n>] [--snoop-filter] [--snoop-filter-entries <n>] [--hop-latency <cycles>] [--update-threshold <n>] [--migratory] [--l2 <size>:<assoc>] [--llc <size>:<assoc>[:<banks>]] [--inclusion <policy>]
 //
-// <protocol> can be "MESI", "MOESI", or "Dragon".
+// <protocol> can be "MESI", "MOESI", "MESIF", "Dragon", "Hybrid", or "Directory".
+// "Profile" instead prints the LRU miss counts of every power-of-two cache size up to <cache_size>
+// and associativity up to <associativity> (plus fully associative), from one pass over the traces.
 //
-// If <input> ends with "_0.data", we auto-resolve _1/_2/_3 in the same folder.
-// If it's a base name with no underscore (e.g., "bodytrack"), we try ./tests/benchmark_traces/bodytrack_0..3.data.
+// If <input> ends with "_0.data", we auto-resolve _1, _2, ... in the same folder.
+// If it's a base name with no underscore (e.g., "bodytrack"), we try ./tests/benchmark_traces/bodytrack_0.data, ...
+// One core is simulated per trace file found, unless --cores <n> selects the first <n> traces.
+//
+// --stream reads the traces in chunks on background threads instead of loading them up front.
+// --replacement selects the replacement policy: "LRU" (default), "PLRU", "SRRIP", "BRRIP", "FIFO" or "Random".
+// --bus-slots models a split-transaction bus with <n> outstanding requests (default 0: pipelined bus)
+// and reports its queueing delays and utilization.
+// --snoop-filter reports the snoops saved by the presence filter that routes the bus snoops
+// to the caches holding the block. The filter is ideal (unbounded) unless --snoop-filter-entries
+// bounds it to <n> entries (a multiple of 8), whose evictions back-invalidate the cached block.
+// --hop-latency sets the cycles per network hop of the Directory protocol (default 10).
+// --update-threshold sets the updates a Hybrid protocol line receives without a local access
+// before it is self-invalidated (default 4, 0 never self-invalidates).
+// --migratory enables the migratory sharing detector of MESI and MOESI, which serves read misses
+// on read-then-written blocks as exclusive, and reports its counters.
+// --l2 adds a private L2 to every core, and --llc a shared LLC split in <banks> banks (default 1),
+// between the L1s and main memory. --inclusion selects their inclusion policy: "inclusive" (default),
+// "non-inclusive" or "exclusive". The hit and miss counts of every level are then reported.
+//
+// <protocol>, <cache_size>, <associativity>, <block_size> and <policy> also accept comma separated lists
+// (e.g. "MESI,MOESI,Dragon"): every combination is then simulated in lockstep from one pass over the traces.
+//
+//   ./coherence --sweep [<input>...] [--json] [--lockstep]
+//
+// runs the parameter sweep of scripts/sweep.sh in one process (all benchmarks in
+// ./tests/benchmark_traces by default) and prints a single CSV table (or JSON array).
+// --lockstep streams the traces once per thread instead of loading them up front.
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
 #include "cache_sim.hpp"
+#include "stack_profiler.hpp"
+#include "sweep.hpp"
+#include "lockstep_sim.hpp"
 #include "utils/utils.hpp"
 
 int main(int argc, char *argv[])
 {
+    // Sweep mode: every input is parsed once and simulated in every configuration.
+    if (argc >= 2 && std::string(argv[1]) == "--sweep")
+    {
+        std::vector<std::string> inputs;
+        bool json_output = false;
+        bool lockstep = false;
+        for (int i = 2; i < argc; i++)
+        {
+            if (std::string(argv[i]) == "--json")
+                json_output = true;
+            else if (std::string(argv[i]) == "--lockstep")
+                lockstep = true;
+            else
+                inputs.push_back(argv[i]);
+        }
+        run_sweep(inputs, json_output, lockstep);
+        return 0;
+    }
+
     // Parse input arguments.
     // Support variable number of arguments (with default values).
     if (argc < 3)
     {
         std::cerr << "Usage: " << argv[0]
-                  << " <protocol: MESI|MOESI|Dragon> <input_base_or_any_0.data> [<cache_size> <associativity> <block_size>] [--json]\n";
+                  << " <protocol: MESI|MOESI|MESIF|Dragon|Hybrid|Directory|Profile> <input_base_or_any_0.data> [<cache_size> <associativity> <block_size>] [--json] [--stream] [--replacement <policy>] [--bus-slots <n>] [--cores <n>] [--snoop-filter] [--snoop-filter-entries <n>] [--hop-latency <cycles>] [--update-threshold <n>] [--migratory] [--l2 <size>:<assoc>] [--llc <size>:<assoc>[:<banks>]] [--inclusion <policy>]\n"
+                  << "       " << argv[0] << " --sweep [<input>...] [--json] [--lockstep]\n";
         return 2;
     }
 
-    // Parse protocol: accepted: MESI/MOESI/Dragon.
+    // Parse protocol: accepted: MESI/MOESI/MESIF/Dragon/Hybrid/Directory.
     std::string protocol = argv[1];
 
-    // Parse file inputs.
-    // All 0..3.data input files must be present.
-    std::string input = argv[2];
-    auto paths = resolve_four(input);
-
-    // Other arguments.
+    // Other arguments (the first value of a list).
     const int cache_size = std::stoi(argv[3]);
     const int assoc = std::stoi(argv[4]);
     const int block_size = std::stoi(argv[5]);
 
-    // Check for JSON output flag.
+    // Check for JSON output, streaming, replacement policy and bus flags.
     bool json_output = false;
+    bool stream_traces = false;
+    std::string replacement = DEFAULT_REPLACEMENT;
+    int bus_slots = DEFAULT_BUS_SLOTS;
+    int num_cores = 0; // Inferred from the trace files.
+    bool snoop_filter = false;
+    int snoop_filter_entries = 0;
+    int hop_latency = DEFAULT_HOP_LATENCY;
+    int update_threshold = DEFAULT_UPDATE_THRESHOLD;
+    bool migratory = false;
+    HierarchyConfig hierarchy;
     for (int i = 6; i < argc; i++)
     {
         if (std::string(argv[i]) == "--json")
         {
             json_output = true;
         }
+        else if (std::string(argv[i]) == "--stream")
+        {
+            stream_traces = true;
+        }
+        else if (std::string(argv[i]) == "--replacement" && i + 1 < argc)
+        {
+            replacement = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--bus-slots" && i + 1 < argc)
+        {
+            bus_slots = std::stoi(argv[++i]);
+        }
+        else if (std::string(argv[i]) == "--snoop-filter")
+        {
+            snoop_filter = true;
+        }
+        else if (std::string(argv[i]) == "--snoop-filter-entries" && i + 1 < argc)
+        {
+            snoop_filter = true;
+            snoop_filter_entries = std::stoi(argv[++i]);
+        }
+        else if (std::string(argv[i]) == "--cores" && i + 1 < argc)
+        {
+            num_cores = std::stoi(argv[++i]);
+        }
+        else if (std::string(argv[i]) == "--hop-latency" && i + 1 < argc)
+        {
+            hop_latency = std::stoi(argv[++i]);
+        }
+        else if (std::string(argv[i]) == "--l2" && i + 1 < argc)
+        {
+            const auto fields = split_list(argv[++i], ':');
+            hierarchy.l2_size = std::stoi(fields[0]);
+            hierarchy.l2_assoc = fields.size() > 1 ? std::stoi(fields[1]) : 1;
+        }
+        else if (std::string(argv[i]) == "--llc" && i + 1 < argc)
+        {
+            const auto fields = split_list(argv[++i], ':');
+            hierarchy.llc_size = std::stoi(fields[0]);
+            hierarchy.llc_assoc = fields.size() > 1 ? std::stoi(fields[1]) : 1;
+            hierarchy.llc_banks = fields.size() > 2 ? std::stoi(fields[2]) : 1;
+        }
+        else if (std::string(argv[i]) == "--inclusion" && i + 1 < argc)
+        {
+            hierarchy.inclusion = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--migratory")
+        {
+            migratory = true;
+        }
+        else if (std::string(argv[i]) == "--update-threshold" && i + 1 < argc)
+        {
+            update_threshold = std::stoi(argv[++i]);
+        }
     }
+    if (bus_slots < 0)
+    {
+        std::cerr << "--bus-slots must not be negative\n";
+        return 2;
+    }
+    if (num_cores < 0)
+    {
+        std::cerr << "--cores must not be negative\n";
+        return 2;
+    }
+    if (snoop_filter_entries < 0 || snoop_filter_entries % SNOOP_FILTER_WAYS != 0)
+    {
+        std::cerr << "--snoop-filter-entries must be a multiple of " << SNOOP_FILTER_WAYS << "\n";
+        return 2;
+    }
+    if (hop_latency < 0)
+    {
+        std::cerr << "--hop-latency must not be negative\n";
+        return 2;
+    }
+    if (std::find(INCLUSION_POLICIES.begin(), INCLUSION_POLICIES.end(), hierarchy.inclusion) == INCLUSION_POLICIES.end())
+    {
+        std::cerr << "Unknown inclusion policy: " << hierarchy.inclusion << "\n";
+        return 2;
+    }
+    if (hierarchy.l2_size < 0 || hierarchy.llc_size < 0 || hierarchy.l2_assoc <= 0 || hierarchy.llc_assoc <= 0 || hierarchy.llc_banks <= 0)
+    {
+        std::cerr << "--l2 and --llc sizes must not be negative, and their <assoc> and <banks> must be positive\n";
+        return 2;
+    }
+    // Every block size of the list must divide the levels.
+    for (const auto &b : split_list(argv[5]))
+    {
+        const int bs = std::stoi(b);
+        if (hierarchy.l2_size % (hierarchy.l2_assoc * bs) != 0 || hierarchy.llc_size % (hierarchy.llc_banks * hierarchy.llc_assoc * bs) != 0)
+        {
+            std::cerr << "--l2 and --llc sizes must be multiples of <assoc> (and <banks>) blocks of " << bs << " bytes\n";
+            return 2;
+        }
+    }
+    if (update_threshold < 0 || update_threshold > UINT16_MAX)
+    {
+        std::cerr << "--update-threshold must be between 0 and " << UINT16_MAX << "\n";
+        return 2;
+    }
+
+    // Parse file inputs.
+    // The input files _0, _1, ... must be present (at least --cores of them).
+    std::string input = argv[2];
+    auto paths = resolve_traces(input, num_cores);
 
-    // Initialize the stats recorder.
-    Stats::initialize(cache_size, assoc, block_size, protocol);
+    // Profile mode: stack distance analysis, no coherence simulation.
+    if (protocol == "Profile")
+    {
+        StackProfiler profiler(cache_size, assoc, block_size);
+        profiler.profile(load_traces_parallel(paths));
+        profiler.print_results(json_output);
+        return 0;
+    }
+
+    // Lockstep mode: several configurations from one pass over the traces.
+    std::vector<SimConfig> configs;
+    for (const auto &p : split_list(argv[1]))
+        for (const auto &cs : split_list(argv[3]))
+            for (const auto &a : split_list(argv[4]))
+                for (const auto &b : split_list(argv[5]))
+                    for (const auto &r : split_list(replacement))
+                        configs.push_back({p, std::stoi(cs), std::stoi(a), std::stoi(b), r, bus_slots, snoop_filter, hop_latency, update_threshold, migratory, hierarchy, snoop_filter_entries});
+    if (configs.size() > 1)
+    {
+        LockstepSim lockstep(configs, paths);
+        lockstep.run();
+
+        if (json_output)
+            std::cout << "[\n";
+        for (size_t i = 0; i < lockstep.size(); i++)
+        {
+            if (json_output && i > 0)
+                std::cout << ",\n";
+            lockstep.get_stats(i).print_results(json_output);
+        }
+        if (json_output)
+            std::cout << "]\n";
+        return 0;
+    }
 
     // CacheSim determines which protocol to use,
     // then loads and simulates using the traces provided.
-    CacheSim sim(protocol, cache_size, assoc, block_size);
-    sim.load_traces(paths);
+    CacheSim sim(configs.front(), static_cast<int>(paths.size()));
+    if (stream_traces)
+        sim.stream_traces(paths);
+    else
+        sim.load_traces(paths);
     sim.run();
 
     // Output the results.
-    Stats::print_results(json_output);
+    sim.get_stats().print_results(json_output);
 
     return 0;
 }
\ No newline at end of file
@@ -1,9 +1,9 @@
-// main.cpp — CS4223 A2 Part 2 (4-core MESI) entrypoint.
+// main.cpp — CS4223 A2 Part 2 (multi-core MESI) entrypoint.
 // CLI (compatible with Part 1):
 //   ./coherence MESI <input_base_or_any_0.data> <cache_size> <associativity> <block_size> [--json]
 //
-// If <input> ends with "_0.data", we auto-resolve _1/_2/_3 in the same folder.
-// If it's a base name with no underscore (e.g., "bodytrack"), we try ./traces/bodytrack_0..3.data then CWD.
+// If <input> ends with "_0.data", we auto-resolve _1, _2, ... in the same folder (one core per file).
+// If it's a base name with no underscore (e.g., "bodytrack"), we try ./traces/bodytrack_0.data, ... then CWD.
 
 #include <iostream>
 #include <string>
@@ -17,43 +17,37 @@ static inline bool file_exists(const std::string &p)
     return ::stat(p.c_str(), &sb) == 0 && S_ISREG(sb.st_mode);
 }
 
-static std::vector<std::string> resolve_four(const std::string &input)
+// traces_from returns "<base>_0.data", "<base>_1.data", ... up to the first missing file.
+static std::vector<std::string> traces_from(const std::string &base)
+{
+    std::vector<std::string> v;
+    while (file_exists(base + "_" + std::to_string(v.size()) + ".data"))
+        v.push_back(base + "_" + std::to_string(v.size()) + ".data");
+    return v;
+}
+
+static std::vector<std::string> resolve_traces(const std::string &input)
 {
-    std::vector<std::string> v(4);
     // Case A: explicit _0.data
     if (input.size() > 7 && input.rfind("_0.data") == input.size() - 7)
     {
-        const auto base = input.substr(0, input.size() - 7);
-        v[0] = base + "_0.data";
-        v[1] = base + "_1.data";
-        v[2] = base + "_2.data";
-        v[3] = base + "_3.data";
-        for (auto &p : v)
-            if (!file_exists(p))
-            {
-                std::cerr << "Missing: " << p << "\n";
-                std::exit(2);
-            }
+        auto v = traces_from(input.substr(0, input.size() - 7));
+        if (v.empty())
+        {
+            std::cerr << "Missing: " << input << "\n";
+            std::exit(2);
+        }
         return v;
     }
     // Case B: bare base (e.g., "bodytrack") — try ./traces then CWD
-    std::vector<std::string> tries{
-        "./traces/" + input + "_0.data", "./traces/" + input + "_1.data",
-        "./traces/" + input + "_2.data", "./traces/" + input + "_3.data"};
-    bool ok = true;
-    for (int i = 0; i < 4; i++)
-        ok = ok && file_exists(tries[i]);
-    if (ok)
-        return tries;
-
-    tries = {input + "_0.data", input + "_1.data", input + "_2.data", input + "_3.data"};
-    ok = true;
-    for (int i = 0; i < 4; i++)
-        ok = ok && file_exists(tries[i]);
-    if (ok)
-        return tries;
+    for (const auto &base : {"./traces/" + input, input})
+    {
+        auto v = traces_from(base);
+        if (!v.empty())
+            return v;
+    }
 
-    std::cerr << "Could not resolve four trace files for base '" << input << "'.\n";
+    std::cerr << "Could not resolve the trace files for base '" << input << "'.\n";
     std::cerr << "Provide e.g.: ./coherence MESI ./traces/bodytrack_0.data 4096 2 32\n";
     std::exit(2);
 }
@@ -81,7 +75,7 @@ int main(int argc, char *argv[])
         if (std::string(argv[i]) == "--json")
             json = true;
 
-    auto paths = resolve_four(input);
+    auto paths = resolve_traces(input);
 
     MESISim sim(cache_size, assoc, block_size);
     sim.load_traces(paths);
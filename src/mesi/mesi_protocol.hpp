@@ -8,6 +8,7 @@ private:
     int curr_core;
     int block_bytes;
     Bus &bus;
+    Stats &stats;
 
     enum MESIState
     {
@@ -30,10 +31,11 @@ private:
     };
 
 public:
-    MESIProtocol(int curr_core, int block_bytes, Bus &bus)
+    MESIProtocol(int curr_core, int block_bytes, Bus &bus, Stats &stats)
         : curr_core(curr_core),
           block_bytes(block_bytes),
-          bus(bus) {};
+          bus(bus),
+          stats(stats) {};
 
     int parse_processor_event(bool is_write, CacheLine *cache_line)
     {
@@ -51,12 +53,19 @@ public:
         switch (cache_line->state)
         {
         case MESIState::M:
+            switch (processor_event)
+            {
+            case MESIPrEvent::PrWr:
+                bus.migratory_write(curr_core, cache_line, false);
+                break;
+            }
             break;
 
         case MESIState::E:
             switch (processor_event)
             {
             case MESIPrEvent::PrWr:
+                bus.migratory_write(curr_core, cache_line, false);
                 cache_line->state = MESIState::M;
                 cache_line->dirty = true;
                 break;
@@ -69,8 +78,9 @@ public:
             {
             case MESIPrEvent::PrWr:
                 // Purely invalidation requests do not contribute to bus traffic.
+                bus.migratory_write(curr_core, cache_line, true);
                 is_shared = bus.trigger_bus_broadcast(curr_core, MESIBusTxn::BusRdX, cache_line, 0);
-                Stats::incr_bus_invalidations();
+                stats.incr_bus_invalidations();
                 cache_line->state = MESIState::M;
                 cache_line->dirty = true;
                 break;
@@ -81,12 +91,23 @@ public:
             switch (processor_event)
             {
             case MESIPrEvent::PrRd:
+                if (bus.migratory_read(curr_core, cache_line))
+                {
+                    // Migratory block: read it exclusively (with ownership), so the write that follows needs no upgrade.
+                    // It stays clean (E) unless the copy it replaces was dirty.
+                    is_shared = bus.trigger_bus_broadcast(curr_core, MESIBusTxn::BusRdX, cache_line, block_bytes / WORD_BYTES);
+                    stats.incr_bus_invalidations();
+                    cache_line->dirty = bus.snooped_dirty();
+                    cache_line->state = cache_line->dirty ? MESIState::M : MESIState::E;
+                    break;
+                }
                 is_shared = bus.trigger_bus_broadcast(curr_core, MESIBusTxn::BusRd, cache_line, block_bytes / WORD_BYTES);
                 cache_line->state = is_shared ? MESIState::S : MESIState::E;
                 break;
             case MESIPrEvent::PrWr:
+                bus.migratory_write(curr_core, cache_line, false);
                 is_shared = bus.trigger_bus_broadcast(curr_core, MESIBusTxn::BusRdX, cache_line, block_bytes / WORD_BYTES);
-                Stats::incr_bus_invalidations();
+                stats.incr_bus_invalidations();
                 cache_line->state = MESIState::M;
                 cache_line->dirty = true;
                 break;
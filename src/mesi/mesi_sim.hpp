@@ -1,4 +1,4 @@
-// mesi_sim.hpp — 4-core MESI simulator (discrete-event, blocking caches)
+// mesi_sim.hpp — multi-core MESI simulator (one core per trace) (discrete-event, blocking caches)
 #pragma once
 #include <vector>
 #include <string>
@@ -31,37 +31,34 @@ class MESISim
 {
 public:
     MESISim(int cache_size, int assoc, int block_size)
-        : B(block_size), N_words(block_size / WORD_BYTES),
-          caches{L1CacheMESI(cache_size, assoc, block_size),
-                 L1CacheMESI(cache_size, assoc, block_size),
-                 L1CacheMESI(cache_size, assoc, block_size),
-                 L1CacheMESI(cache_size, assoc, block_size)}
+        : B(block_size), N_words(block_size / WORD_BYTES), cache_size(cache_size), assoc(assoc)
     {
         assert(B > 0 && (B % WORD_BYTES) == 0);
     }
 
     void load_traces(const std::vector<std::string> &paths)
     {
-        if (paths.size() != 4)
+        if (paths.empty())
         {
-            std::cerr << "need 4 traces\n";
+            std::cerr << "need at least one trace\n";
             std::exit(2);
         }
-        tr.resize(4);
-        for (int c = 0; c < 4; c++)
+        tr.resize(paths.size());
+        caches.assign(paths.size(), L1CacheMESI(cache_size, assoc, B));
+        for (int c = 0; c < cores(); c++)
             tr[c] = parse_trace(paths[c]);
     }
 
     void run()
     {
         // Per-core bookkeeping
-        ready_at.assign(4, 0);
-        cur_idx.assign(4, 0);
-        st.assign(4, CoreStats{});
+        ready_at.assign(cores(), 0);
+        cur_idx.assign(cores(), 0);
+        st.assign(cores(), CoreStats{});
         overall_bus = Bus{};
 
         // Prime the first issue times by their initial gaps
-        for (int c = 0; c < 4; c++)
+        for (int c = 0; c < cores(); c++)
         {
             if (cur_idx[c] < tr[c].size())
             {
@@ -74,7 +71,7 @@ public:
 
         // Event-loop: choose next core to issue based on ready_at + next gap
         int live = 0;
-        for (int c = 0; c < 4; c++)
+        for (int c = 0; c < cores(); c++)
             if (cur_idx[c] < tr[c].size())
                 live++;
 
@@ -82,7 +79,7 @@ public:
         {
             int next_core = -1;
             uint64_t next_time = UINT64_MAX;
-            for (int c = 0; c < 4; c++)
+            for (int c = 0; c < cores(); c++)
             {
                 if (cur_idx[c] >= tr[c].size())
                     continue;
@@ -154,7 +151,7 @@ public:
                         // Simulate bus arbitration
                         uint64_t end = overall_bus.schedule(ready_at[c], t);
                         // Apply snoop to others
-                        for (int k = 0; k < 4; k++)
+                        for (int k = 0; k < cores(); k++)
                             if (k != c)
                                 caches[k].on_busupgr(item.addr, end);
                         // Service time is 1 cycle beyond the core hit (we already add 1 hit cycle below)
@@ -170,7 +167,7 @@ public:
                         bool c2c = false;
                         bool any_inval = false;
                         // First pass snoop to determine suppliers
-                        for (int k = 0; k < 4; k++)
+                        for (int k = 0; k < cores(); k++)
                             if (k != c)
                             {
                                 if (t.op == BusOp::BusRd)
@@ -225,7 +222,7 @@ public:
 
         // Final exec times
         uint64_t max_t = 0;
-        for (int c = 0; c < 4; c++)
+        for (int c = 0; c < cores(); c++)
         {
             st[c].exec_cycles = ready_at[c];
             if (ready_at[c] > max_t)
@@ -240,13 +237,13 @@ public:
         {
             std::cout << "{\n";
             std::cout << "  \"overall_execution_cycles\": " << overall_exec << ",\n";
-            std::cout << "  \"per_core_execution_cycles\": [" << st[0].exec_cycles << "," << st[1].exec_cycles << "," << st[2].exec_cycles << "," << st[3].exec_cycles << "],\n";
-            std::cout << "  \"per_core_compute_cycles\": [" << st[0].compute_cycles << "," << st[1].compute_cycles << "," << st[2].compute_cycles << "," << st[3].compute_cycles << "],\n";
-            std::cout << "  \"per_core_loads\": [" << st[0].loads << "," << st[1].loads << "," << st[2].loads << "," << st[3].loads << "],\n";
-            std::cout << "  \"per_core_stores\": [" << st[0].stores << "," << st[1].stores << "," << st[2].stores << "," << st[3].stores << "],\n";
-            std::cout << "  \"per_core_idle_cycles\": [" << st[0].idle_cycles << "," << st[1].idle_cycles << "," << st[2].idle_cycles << "," << st[3].idle_cycles << "],\n";
-            std::cout << "  \"per_core_hits\": [" << st[0].hits << "," << st[1].hits << "," << st[2].hits << "," << st[3].hits << "],\n";
-            std::cout << "  \"per_core_misses\": [" << st[0].misses << "," << st[1].misses << "," << st[2].misses << "," << st[3].misses << "],\n";
+            std::cout << "  \"per_core_execution_cycles\": " << list(&CoreStats::exec_cycles) << ",\n";
+            std::cout << "  \"per_core_compute_cycles\": " << list(&CoreStats::compute_cycles) << ",\n";
+            std::cout << "  \"per_core_loads\": " << list(&CoreStats::loads) << ",\n";
+            std::cout << "  \"per_core_stores\": " << list(&CoreStats::stores) << ",\n";
+            std::cout << "  \"per_core_idle_cycles\": " << list(&CoreStats::idle_cycles) << ",\n";
+            std::cout << "  \"per_core_hits\": " << list(&CoreStats::hits) << ",\n";
+            std::cout << "  \"per_core_misses\": " << list(&CoreStats::misses) << ",\n";
             std::cout << "  \"bus_data_traffic_bytes\": " << overall_bus.total_data_bytes << ",\n";
             std::cout << "  \"bus_invalidations_or_updates\": " << overall_bus.invalidation_broadcasts << ",\n";
             std::cout << "  \"protocol\": \"MESI\",\n";
@@ -258,13 +255,11 @@ public:
         else
         {
             std::cout << "Overall Execution Cycles: " << overall_exec << "\n";
-            std::cout << "Per-core execution cycles: [" << st[0].exec_cycles << "," << st[1].exec_cycles << "," << st[2].exec_cycles << "," << st[3].exec_cycles << "]\n";
-            std::cout << "Compute cycles per core:   [" << st[0].compute_cycles << "," << st[1].compute_cycles << "," << st[2].compute_cycles << "," << st[3].compute_cycles << "]\n";
-            std::cout << "Loads/stores per core:     [" << st[0].loads << "," << st[1].loads << "," << st[2].loads << "," << st[3].loads << "] / ["
-                      << st[0].stores << "," << st[1].stores << "," << st[2].stores << "," << st[3].stores << "]\n";
-            std::cout << "Idle cycles per core:      [" << st[0].idle_cycles << "," << st[1].idle_cycles << "," << st[2].idle_cycles << "," << st[3].idle_cycles << "]\n";
-            std::cout << "Hits/misses per core:      [" << st[0].hits << "," << st[1].hits << "," << st[2].hits << "," << st[3].hits << "] / ["
-                      << st[0].misses << "," << st[1].misses << "," << st[2].misses << "," << st[3].misses << "]\n";
+            std::cout << "Per-core execution cycles: " << list(&CoreStats::exec_cycles) << "\n";
+            std::cout << "Compute cycles per core:   " << list(&CoreStats::compute_cycles) << "\n";
+            std::cout << "Loads/stores per core:     " << list(&CoreStats::loads) << " / " << list(&CoreStats::stores) << "\n";
+            std::cout << "Idle cycles per core:      " << list(&CoreStats::idle_cycles) << "\n";
+            std::cout << "Hits/misses per core:      " << list(&CoreStats::hits) << " / " << list(&CoreStats::misses) << "\n";
             std::cout << "Bus data traffic (bytes):  " << overall_bus.total_data_bytes << "\n";
             std::cout << "Invalidation broadcasts:   " << overall_bus.invalidation_broadcasts << "\n";
         }
@@ -326,10 +321,22 @@ private:
         return out;
     }
 
+    // list formats a per-core metric as "[v0,v1,...]".
+    std::string list(uint64_t CoreStats::*metric) const
+    {
+        std::string out = "[";
+        for (int c = 0; c < cores(); c++)
+            out += (c ? "," : "") + std::to_string(st[c].*metric);
+        return out + "]";
+    }
+
+    int cores() const { return static_cast<int>(tr.size()); }
+
     int B;       // block bytes
     int N_words; // words per block
     Bus overall_bus;
-    L1CacheMESI caches[4];
+    int cache_size, assoc;
+    std::vector<L1CacheMESI> caches;
 
     std::vector<std::vector<TraceItem>> tr;
     std::vector<uint64_t> ready_at;
@@ -0,0 +1,190 @@
+#pragma once
+#include "../coherence_protocol.hpp"
+#include "../utils/stats.hpp"
+
+// MESIFProtocol is MESI with a Forward (F) state: of the caches sharing a clean block,
+// only the one in F answers a read with a cache-to-cache transfer (see Bus::trigger_bus_forward).
+// F migrates to the newest requester, and the previous forwarder keeps a Shared copy.
+class MESIFProtocol : public CoherenceProtocol
+{
+private:
+    int curr_core;
+    int block_bytes;
+    Bus &bus;
+    Stats &stats;
+
+    enum MESIFState
+    {
+        M,
+        E,
+        S,
+        I,
+        F,
+    };
+
+    enum MESIFPrEvent
+    {
+        PrWr,
+        PrRd,
+    };
+
+    enum MESIFBusTxn
+    {
+        BusRdX, // BusRdX causes bus invalidations sent over the bus.
+        BusRd,
+    };
+
+    // If the block is shared but no cache supplied it (the forwarder was evicted), it comes from memory.
+    void fetch_unsupplied(bool is_shared, CacheLine *cache_line)
+    {
+        if (!is_shared || cache_line->valid)
+            return;
+        bus.fetch_block(curr_core, cache_line);
+        stats.incr_memory_fetches();
+        stats.incr_shared_memory_fetches();
+        cache_line->valid = true;
+    }
+
+public:
+    MESIFProtocol(int curr_core, int block_bytes, Bus &bus, Stats &stats)
+        : curr_core(curr_core),
+          block_bytes(block_bytes),
+          bus(bus),
+          stats(stats) {};
+
+    int parse_processor_event(bool is_write, CacheLine *cache_line)
+    {
+        (void)cache_line; // Unused parameter.
+        return is_write ? MESIFPrEvent::PrWr : MESIFPrEvent::PrRd;
+    }
+
+    bool on_processor_event(int processor_event, CacheLine *cache_line) override
+    {
+        // Set default state if invalid.
+        if (!cache_line->valid)
+            cache_line->state = MESIFState::I;
+
+        bool is_shared = false;
+        switch (cache_line->state)
+        {
+        case MESIFState::M:
+            break;
+
+        case MESIFState::E:
+            switch (processor_event)
+            {
+            case MESIFPrEvent::PrWr:
+                cache_line->state = MESIFState::M;
+                cache_line->dirty = true;
+                break;
+            }
+            break;
+
+        case MESIFState::S:
+        case MESIFState::F:
+            is_shared = true;
+            switch (processor_event)
+            {
+            case MESIFPrEvent::PrWr:
+                // Purely invalidation requests do not contribute to bus traffic.
+                is_shared = bus.trigger_bus_forward(curr_core, MESIFBusTxn::BusRdX, cache_line, 0);
+                stats.incr_bus_invalidations();
+                cache_line->state = MESIFState::M;
+                cache_line->dirty = true;
+                break;
+            }
+            break;
+
+        case MESIFState::I:
+            switch (processor_event)
+            {
+            case MESIFPrEvent::PrRd:
+                is_shared = bus.trigger_bus_forward(curr_core, MESIFBusTxn::BusRd, cache_line, block_bytes / WORD_BYTES);
+                fetch_unsupplied(is_shared, cache_line);
+                // The newest requester becomes the forwarder.
+                cache_line->state = is_shared ? MESIFState::F : MESIFState::E;
+                break;
+            case MESIFPrEvent::PrWr:
+                is_shared = bus.trigger_bus_forward(curr_core, MESIFBusTxn::BusRdX, cache_line, block_bytes / WORD_BYTES);
+                fetch_unsupplied(is_shared, cache_line);
+                stats.incr_bus_invalidations();
+                cache_line->state = MESIFState::M;
+                cache_line->dirty = true;
+                break;
+            }
+            break;
+
+        default:
+            std::cerr << "Invalid MESIF state\n";
+            break;
+        }
+
+        return is_shared;
+    }
+
+    void on_snoop_event(int bus_transaction, CacheLine *cache_line) override
+    {
+        // If invalid, no snoop processing required.
+        if (cache_line == nullptr || !cache_line->valid)
+            return;
+
+        switch (cache_line->state)
+        {
+        case MESIFState::M:
+            bus.supply_data();
+            cache_line->dirty = false;
+            switch (bus_transaction)
+            {
+            case MESIFBusTxn::BusRd:
+                // The requester becomes the (clean) forwarder, so the dirty data is written back.
+                bus.access_main_memory(curr_core, CYCLE_WRITEBACK_DIRTY);
+                cache_line->state = MESIFState::S;
+                break;
+            case MESIFBusTxn::BusRdX:
+                // Data flushed via cache-to-cache transfer.
+                cache_line->valid = false;
+                cache_line->state = MESIFState::I;
+                break;
+            }
+            break;
+
+        case MESIFState::E:
+        case MESIFState::F:
+            // The only cache answering for a clean block.
+            bus.supply_data();
+            switch (bus_transaction)
+            {
+            case MESIFBusTxn::BusRd:
+                stats.incr_forwarded_reads();
+                cache_line->state = MESIFState::S;
+                break;
+            case MESIFBusTxn::BusRdX:
+                cache_line->valid = false;
+                cache_line->state = MESIFState::I;
+                break;
+            }
+            break;
+
+        case MESIFState::S:
+            switch (bus_transaction)
+            {
+            case MESIFBusTxn::BusRd:
+                break;
+            case MESIFBusTxn::BusRdX:
+                cache_line->valid = false;
+                cache_line->state = MESIFState::I;
+                break;
+            }
+            break;
+
+        case MESIFState::I:
+            break;
+
+        default:
+            std::cerr << "Invalid MESIF state\n";
+            break;
+        }
+
+        return;
+    }
+};
@@ -0,0 +1,86 @@
+// migratory_detector.hpp contains the migratory sharing detector of the MESI and MOESI protocols.
+#pragma once
+#include <unordered_map>
+#include "utils/types.hpp"
+
+// MigratoryDetector classifies blocks as migratory, i.e. read then written by one core
+// at a time (Stenström et al., 1993). A block becomes migratory when a core upgrades its
+// shared copy while exactly one other cache holds it, and another core wrote it last.
+//
+// A read miss on a migratory block is then served as exclusive, so the read-then-write
+// needs one bus transaction instead of two. If another core reads the block before the
+// exclusive reader wrote it, or the exclusive reader evicts it unwritten, the prediction was
+// wrong and the block is no longer migratory.
+//
+// Only blocks upgraded from a shared copy are tracked, so private blocks cost no entry.
+class MigratoryDetector
+{
+private:
+    struct Entry
+    {
+        int last_writer = -1;
+        int pending_reader = -1; // Core that read the block exclusively and has not written it yet.
+        bool migratory = false;
+    };
+    std::unordered_map<u32, Entry> blocks;
+
+public:
+    enum ReadOutcome
+    {
+        Shared,       // Ordinary read.
+        Exclusive,    // Read served as exclusive.
+        Mispredicted, // Ordinary read, the block stopped being migratory.
+    };
+
+    // on_read_miss returns how core's read miss on block is served.
+    ReadOutcome on_read_miss(u32 block, int core)
+    {
+        auto it = blocks.find(block);
+        if (it == blocks.end() || !it->second.migratory)
+            return ReadOutcome::Shared;
+
+        Entry &e = it->second;
+        if (e.pending_reader >= 0 && e.pending_reader != core)
+        {
+            e.migratory = false;
+            e.pending_reader = -1;
+            return ReadOutcome::Mispredicted;
+        }
+        e.pending_reader = core;
+        return ReadOutcome::Exclusive;
+    }
+
+    // on_write records a write of core to block. upgrade is set if the write invalidates
+    // core's shared copy, and other_holders is the number of other caches holding it.
+    //
+    // Returns true if the write follows an exclusive read of core (its upgrade was saved).
+    // Sets detected if the block became migratory.
+    bool on_write(u32 block, int core, bool upgrade, int other_holders, bool &detected)
+    {
+        detected = false;
+        auto it = upgrade ? blocks.try_emplace(block).first : blocks.find(block);
+        if (it == blocks.end())
+            return false;
+
+        Entry &e = it->second;
+        const bool saved = e.pending_reader == core;
+        e.pending_reader = -1;
+
+        detected = upgrade && other_holders == 1 && e.last_writer >= 0 && e.last_writer != core && !e.migratory;
+        e.migratory = e.migratory || detected;
+        e.last_writer = core;
+        return saved;
+    }
+
+    // on_evict records that core dropped its copy of block. Returns true if core read it
+    // exclusively and never wrote it (a misprediction, the block is no longer migratory).
+    bool on_evict(u32 block, int core)
+    {
+        auto it = blocks.find(block);
+        if (it == blocks.end() || it->second.pending_reader != core)
+            return false;
+        it->second.migratory = false;
+        it->second.pending_reader = -1;
+        return true;
+    }
+};
@@ -29,6 +29,7 @@ private:
     int curr_core;
     int block_bytes;
     Bus &bus;
+    Stats &stats;
 
     enum MOESIState
     {
@@ -52,10 +53,11 @@ private:
     };
 
 public:
-    MOESIProtocol(int curr_core, int block_bytes, Bus &bus)
+    MOESIProtocol(int curr_core, int block_bytes, Bus &bus, Stats &stats)
         : curr_core(curr_core),
           block_bytes(block_bytes),
-          bus(bus) {};
+          bus(bus),
+          stats(stats) {};
 
     int parse_processor_event(bool is_write, CacheLine *cache_line) override
     {
@@ -75,6 +77,12 @@ public:
         {
         case MOESIState::M:
             // Modified: already have exclusive dirty copy
+            switch (processor_event)
+            {
+            case MOESIPrEvent::PrWr:
+                bus.migratory_write(curr_core, cache_line, false);
+                break;
+            }
             break;
 
         case MOESIState::O:
@@ -85,8 +93,9 @@ public:
             case MOESIPrEvent::PrWr:
                 // Need to invalidate other sharers via BusRdX
                 // No data transfer involved.
+                bus.migratory_write(curr_core, cache_line, true);
                 is_shared = bus.trigger_bus_broadcast(curr_core, MOESIBusTxn::BusRdX, cache_line, 0);
-                Stats::incr_bus_invalidations();
+                stats.incr_bus_invalidations();
                 cache_line->state = MOESIState::M;
                 cache_line->dirty = true;
                 break;
@@ -99,6 +108,7 @@ public:
             {
             case MOESIPrEvent::PrWr:
                 // Silent upgrade E->M (no bus transaction needed!)
+                bus.migratory_write(curr_core, cache_line, false);
                 cache_line->state = MOESIState::M;
                 cache_line->dirty = true;
                 break;
@@ -113,8 +123,9 @@ public:
             case MOESIPrEvent::PrWr:
                 // Need to invalidate other sharers via BusRdX
                 // No data transfer involved.
+                bus.migratory_write(curr_core, cache_line, true);
                 is_shared = bus.trigger_bus_broadcast(curr_core, MOESIBusTxn::BusRdX, cache_line, 0);
-                Stats::incr_bus_invalidations();
+                stats.incr_bus_invalidations();
                 cache_line->state = MOESIState::M;
                 cache_line->dirty = true;
                 break;
@@ -127,14 +138,25 @@ public:
             switch (processor_event)
             {
             case MOESIPrEvent::PrRd:
+                if (bus.migratory_read(curr_core, cache_line))
+                {
+                    // Migratory block: BusRdX to get an exclusive copy, so the write that follows needs no upgrade.
+                    // It stays clean (E) unless the copy it replaces was dirty (M or O).
+                    is_shared = bus.trigger_bus_broadcast(curr_core, MOESIBusTxn::BusRdX, cache_line, block_bytes / WORD_BYTES);
+                    stats.incr_bus_invalidations();
+                    cache_line->dirty = bus.snooped_dirty();
+                    cache_line->state = cache_line->dirty ? MOESIState::M : MOESIState::E;
+                    break;
+                }
                 // Broadcast BusRd to get shared or exclusive copy
                 is_shared = bus.trigger_bus_broadcast(curr_core, MOESIBusTxn::BusRd, cache_line, block_bytes / WORD_BYTES);
                 cache_line->state = is_shared ? MOESIState::S : MOESIState::E;
                 break;
             case MOESIPrEvent::PrWr:
                 // Broadcast BusRdX to get exclusive copy
+                bus.migratory_write(curr_core, cache_line, false);
                 is_shared = bus.trigger_bus_broadcast(curr_core, MOESIBusTxn::BusRdX, cache_line, block_bytes / WORD_BYTES);
-                Stats::incr_bus_invalidations();
+                stats.incr_bus_invalidations();
                 cache_line->state = MOESIState::M;
                 cache_line->dirty = true;
                 break;
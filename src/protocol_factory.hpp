@@ -1,27 +1,51 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <vector>
 #include "utils/types.hpp"
 #include "cache.hpp"
 #include "bus.cpp"
 #include "coherence_protocol.hpp"
 #include "mesi/mesi_protocol.hpp"
 #include "dragon/dragon_protocol.hpp"
+#include "hybrid/hybrid_protocol.hpp"
 #include "moesi/moesi_protocol.hpp"
+#include "mesif/mesif_protocol.hpp"
+#include "directory/directory_protocol.hpp"
+#include "replacement/replacement_policy.hpp"
+#include "replacement/lru_policy.hpp"
+#include "replacement/plru_policy.hpp"
+#include "replacement/rrip_policy.hpp"
+#include "replacement/fifo_policy.hpp"
+#include "replacement/random_policy.hpp"
+#include "utils/arena.hpp"
 
-std::unique_ptr<CoherenceProtocol> make_protocol(const std::string &name, int curr_core, int block_size, Bus &bus)
+std::unique_ptr<CoherenceProtocol> make_protocol(const std::string &name, int curr_core, int block_size, Bus &bus, Stats &stats,
+                                                 int update_threshold = DEFAULT_UPDATE_THRESHOLD)
 {
     if (name == "MESI")
     {
-        return std::make_unique<MESIProtocol>(curr_core, block_size, bus);
+        return std::make_unique<MESIProtocol>(curr_core, block_size, bus, stats);
     }
     else if (name == "Dragon")
     {
-        return std::make_unique<DragonProtocol>(curr_core, block_size, bus);
+        return std::make_unique<DragonProtocol>(curr_core, block_size, bus, stats);
     }
     else if (name == "MOESI")
     {
-        return std::make_unique<MOESIProtocol>(curr_core, block_size, bus);
+        return std::make_unique<MOESIProtocol>(curr_core, block_size, bus, stats);
+    }
+    else if (name == "Hybrid")
+    {
+        return std::make_unique<HybridProtocol>(curr_core, block_size, update_threshold, bus, stats);
+    }
+    else if (name == "MESIF")
+    {
+        return std::make_unique<MESIFProtocol>(curr_core, block_size, bus, stats);
+    }
+    else if (name == "Directory")
+    {
+        return std::make_unique<DirectoryProtocol>(curr_core, block_size, bus, stats);
     }
     else
     {
@@ -30,9 +54,61 @@ std::unique_ptr<CoherenceProtocol> make_protocol(const std::string &name, int cu
     }
 }
 
-std::unique_ptr<Cache> make_cache(const std::string &protocol_name,
-                                  int cache_size, int assoc, int block_size, int curr_core, Bus &bus)
+// Replacement policies accepted by make_replacement.
+static const std::vector<std::string> REPLACEMENT_POLICIES = {"LRU", "PLRU", "SRRIP", "BRRIP", "FIFO", "Random"};
+
+std::unique_ptr<ReplacementPolicy> make_replacement(const std::string &name, int num_sets, int assoc, int curr_core, Arena &arena)
+{
+    // The random choices of each core are seeded differently, but identically in every run.
+    const u64 seed = 0x9E3779B97F4A7C15ULL * (curr_core + 1);
+    if (name == "LRU")
+    {
+        return std::make_unique<LRUPolicy>(num_sets, assoc, arena);
+    }
+    else if (name == "PLRU")
+    {
+        return std::make_unique<PLRUPolicy>(num_sets, assoc, arena);
+    }
+    else if (name == "SRRIP" || name == "BRRIP")
+    {
+        return std::make_unique<RRIPPolicy>(num_sets, assoc, name == "BRRIP", seed, arena);
+    }
+    else if (name == "FIFO")
+    {
+        return std::make_unique<FIFOPolicy>(num_sets, assoc, arena);
+    }
+    else if (name == "Random")
+    {
+        return std::make_unique<RandomPolicy>(assoc, seed);
+    }
+    else
+    {
+        std::cerr << "Unknown replacement policy: " << name << "\n";
+        std::exit(2);
+    }
+}
+
+// cache_arena_bytes returns the arena bytes needed by one cache and its replacement policy.
+size_t cache_arena_bytes(const std::string &replacement, int cache_size, int assoc, int block_size)
+{
+    const int num_sets = cache_size / (assoc * block_size);
+    size_t bytes = Cache::arena_bytes(cache_size, assoc, block_size);
+    if (replacement == "LRU")
+        bytes += LRUPolicy::arena_bytes(num_sets, assoc);
+    else if (replacement == "PLRU")
+        bytes += PLRUPolicy::arena_bytes(num_sets, assoc);
+    else if (replacement == "SRRIP" || replacement == "BRRIP")
+        bytes += RRIPPolicy::arena_bytes(num_sets, assoc);
+    else if (replacement == "FIFO")
+        bytes += FIFOPolicy::arena_bytes(num_sets, assoc);
+    return bytes;
+}
+
+std::unique_ptr<Cache> make_cache(const std::string &protocol_name, const std::string &replacement,
+                                  int cache_size, int assoc, int block_size, int curr_core, Bus &bus, Stats &stats, Arena &arena,
+                                  int update_threshold = DEFAULT_UPDATE_THRESHOLD)
 {
-    auto protocol = make_protocol(protocol_name, curr_core, block_size, bus);
-    return std::make_unique<Cache>(cache_size, assoc, block_size, curr_core, bus, protocol.release());
+    auto protocol = make_protocol(protocol_name, curr_core, block_size, bus, stats, update_threshold);
+    auto policy = make_replacement(replacement, cache_size / (assoc * block_size), assoc, curr_core, arena);
+    return std::make_unique<Cache>(cache_size, assoc, block_size, curr_core, bus, stats, protocol.release(), std::move(policy), arena);
 }
@@ -0,0 +1,30 @@
+#pragma once
+#include "replacement_policy.hpp"
+#include "../utils/arena.hpp"
+
+// FIFO Policy: evicts the ways of a set in circular order (one pointer per set).
+//
+// Since invalid ways are filled lowest first, this is the fill order, except that a
+// way refilled after a coherence invalidation keeps its old place in the circle.
+class FIFOPolicy : public ReplacementPolicy
+{
+private:
+    int assoc;
+    u32 *next; // Per set, the next way to evict.
+
+public:
+    static size_t arena_bytes(int num_sets, int) { return Arena::bytes_for<u32>(num_sets); }
+
+    FIFOPolicy(int num_sets, int assoc, Arena &arena)
+        : assoc(assoc), next(arena.take<u32>(num_sets)) {}
+
+    void on_fill(int set, int way, u64) override
+    {
+        if (next[set] == static_cast<u32>(way))
+            next[set] = (next[set] + 1) % assoc;
+    }
+
+    void on_hit(int, int, u64) override {}
+
+    int victim(int set) override { return static_cast<int>(next[set]); }
+};
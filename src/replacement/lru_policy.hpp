@@ -0,0 +1,39 @@
+#pragma once
+#include "replacement_policy.hpp"
+#include "../utils/arena.hpp"
+
+// LRU Policy: true least recently used.
+//
+// Each line keeps the time (core exec cycles) at which its last access completed,
+// and the line with the oldest time is evicted (the lowest way on ties).
+class LRUPolicy : public ReplacementPolicy
+{
+private:
+    int assoc;
+    u64 *stamps; // Indexed by set * assoc + way.
+
+public:
+    static size_t arena_bytes(int num_sets, int assoc) { return Arena::bytes_for<u64>(static_cast<size_t>(num_sets) * assoc); }
+
+    LRUPolicy(int num_sets, int assoc, Arena &arena)
+        : assoc(assoc), stamps(arena.take<u64>(static_cast<size_t>(num_sets) * assoc)) {}
+
+    void on_fill(int set, int way, u64 now) override { stamps[static_cast<size_t>(set) * assoc + way] = now; }
+    void on_hit(int set, int way, u64 now) override { stamps[static_cast<size_t>(set) * assoc + way] = now; }
+
+    int victim(int set) override
+    {
+        const u64 *set_stamps = stamps + static_cast<size_t>(set) * assoc;
+        int victim_way = 0;
+        u64 oldest = set_stamps[0];
+        for (int w = 1; w < assoc; w++)
+        {
+            if (set_stamps[w] < oldest)
+            {
+                oldest = set_stamps[w];
+                victim_way = w;
+            }
+        }
+        return victim_way;
+    }
+};
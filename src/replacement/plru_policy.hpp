@@ -0,0 +1,68 @@
+#pragma once
+#include <iostream>
+#include "replacement_policy.hpp"
+#include "../utils/arena.hpp"
+
+// PLRU Policy: tree pseudo-LRU, as in most hardware caches.
+//
+// Each set keeps a binary tree of assoc - 1 bits over its ways. Every bit points to
+// the half of its subtree that was used less recently; an access flips the bits on
+// its path to point away from it, and the victim is found by following the bits.
+// Requires a power-of-two associativity.
+class PLRUPolicy : public ReplacementPolicy
+{
+private:
+    int levels;      // log2(assoc).
+    int words;       // Words of tree bits per set.
+    u64 *tree;       // Bit n of a set's words is tree node n (the root is node 1).
+
+    bool get(int set, int node) const { return (tree[static_cast<size_t>(set) * words + node / 64] >> (node % 64)) & 1; }
+
+    void put(int set, int node, bool bit)
+    {
+        u64 &word = tree[static_cast<size_t>(set) * words + node / 64];
+        const u64 mask = 1ULL << (node % 64);
+        word = bit ? (word | mask) : (word & ~mask);
+    }
+
+    void touch(int set, int way)
+    {
+        int node = 1;
+        for (int l = levels - 1; l >= 0; l--)
+        {
+            int dir = (way >> l) & 1;
+            put(set, node, dir == 0); // Point to the other half.
+            node = 2 * node + dir;
+        }
+    }
+
+public:
+    static size_t arena_bytes(int num_sets, int assoc) { return Arena::bytes_for<u64>(static_cast<size_t>(num_sets) * ((assoc + 63) / 64)); }
+
+    PLRUPolicy(int num_sets, int assoc, Arena &arena)
+        : levels(__builtin_ctz(static_cast<unsigned>(assoc))), words((assoc + 63) / 64)
+    {
+        if ((assoc & (assoc - 1)) != 0)
+        {
+            std::cerr << "PLRU needs a power-of-two associativity\n";
+            std::exit(2);
+        }
+        tree = arena.take<u64>(static_cast<size_t>(num_sets) * words);
+    }
+
+    void on_fill(int set, int way, u64) override { touch(set, way); }
+    void on_hit(int set, int way, u64) override { touch(set, way); }
+
+    int victim(int set) override
+    {
+        int node = 1;
+        int way = 0;
+        for (int l = 0; l < levels; l++)
+        {
+            int dir = get(set, node);
+            way = 2 * way + dir;
+            node = 2 * node + dir;
+        }
+        return way;
+    }
+};
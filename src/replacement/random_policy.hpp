@@ -0,0 +1,25 @@
+#pragma once
+#include "replacement_policy.hpp"
+
+// Random Policy: evicts a uniformly random way, with no per-line metadata.
+// The generator (xorshift64) is seeded per core, so runs are reproducible.
+class RandomPolicy : public ReplacementPolicy
+{
+private:
+    int assoc;
+    u64 rng;
+
+public:
+    RandomPolicy(int assoc, u64 seed) : assoc(assoc), rng(seed) {}
+
+    void on_fill(int, int, u64) override {}
+    void on_hit(int, int, u64) override {}
+
+    int victim(int) override
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        return static_cast<int>(rng % static_cast<u64>(assoc));
+    }
+};
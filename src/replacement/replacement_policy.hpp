@@ -0,0 +1,22 @@
+#pragma once
+#include "../utils/types.hpp"
+
+// Abstract base class for cache replacement policies.
+//
+// The policy only ranks the valid lines of a full set: the cache fills invalid ways
+// first, and notifies the policy of every fill and hit once the access completes.
+// Each policy keeps its per-line metadata in arrays carved out of the simulation's arena.
+class ReplacementPolicy
+{
+public:
+    virtual ~ReplacementPolicy() = default;
+
+    // on_fill is called when a line is allocated into the way of the set (on a miss).
+    virtual void on_fill(int set, int way, u64 now) = 0;
+
+    // on_hit is called when the valid line in the way of the set is accessed again.
+    virtual void on_hit(int set, int way, u64 now) = 0;
+
+    // victim returns the way to evict from a full set.
+    virtual int victim(int set) = 0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include "replacement_policy.hpp"
+#include "../utils/arena.hpp"
+
+// RRIP Policy: re-reference interval prediction (Jaleel et al., ISCA 2010).
+//
+// Each line keeps a 2-bit re-reference prediction value (RRPV): 0 on a hit, and
+// "long" (2) on a fill for SRRIP, so lines that are never reused (streaming data)
+// are evicted before the reused working set. BRRIP fills with "distant" (3) and only
+// once every 32 fills with "long", which resists thrashing by working sets larger
+// than the cache. The victim is the first line with RRPV 3, aging all lines until one exists.
+class RRIPPolicy : public ReplacementPolicy
+{
+private:
+    static constexpr u8 RRPV_MAX = 3;
+    static constexpr int BRRIP_LONG_FILL_PERIOD = 32;
+
+    int assoc;
+    bool bimodal; // BRRIP instead of SRRIP.
+    u8 *rrpv;     // Indexed by set * assoc + way.
+    u64 rng;      // Bimodal fill choice (xorshift64).
+
+public:
+    static size_t arena_bytes(int num_sets, int assoc) { return Arena::bytes_for<u8>(static_cast<size_t>(num_sets) * assoc); }
+
+    RRIPPolicy(int num_sets, int assoc, bool bimodal, u64 seed, Arena &arena)
+        : assoc(assoc), bimodal(bimodal), rrpv(arena.take<u8>(static_cast<size_t>(num_sets) * assoc)), rng(seed) {}
+
+    void on_fill(int set, int way, u64) override
+    {
+        u8 value = RRPV_MAX - 1;
+        if (bimodal)
+        {
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+            if (rng % BRRIP_LONG_FILL_PERIOD != 0)
+                value = RRPV_MAX;
+        }
+        rrpv[static_cast<size_t>(set) * assoc + way] = value;
+    }
+
+    void on_hit(int set, int way, u64) override { rrpv[static_cast<size_t>(set) * assoc + way] = 0; }
+
+    int victim(int set) override
+    {
+        u8 *set_rrpv = rrpv + static_cast<size_t>(set) * assoc;
+        while (true)
+        {
+            for (int w = 0; w < assoc; w++)
+            {
+                if (set_rrpv[w] == RRPV_MAX)
+                    return w;
+            }
+            for (int w = 0; w < assoc; w++)
+                set_rrpv[w]++;
+        }
+    }
+};
@@ -0,0 +1,22 @@
+// sim_config.hpp contains the configuration of one simulation.
+#pragma once
+#include <string>
+#include "hierarchy/memory_hierarchy.hpp"
+#include "utils/constants.hpp"
+
+// SimConfig is the configuration of one simulation.
+struct SimConfig
+{
+    std::string protocol;
+    int cache_size;
+    int assoc;
+    int block_size;
+    std::string replacement = DEFAULT_REPLACEMENT;
+    int bus_slots = DEFAULT_BUS_SLOTS;
+    bool snoop_filter = false;
+    int hop_latency = DEFAULT_HOP_LATENCY;
+    int update_threshold = DEFAULT_UPDATE_THRESHOLD;
+    bool migratory = false;
+    HierarchyConfig hierarchy = {};
+    int snoop_filter_entries = 0;
+};
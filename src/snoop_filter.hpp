@@ -0,0 +1,168 @@
+// snoop_filter.hpp contains the presence filter that routes bus snoops to the caches
+// holding a block.
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include "utils/types.hpp"
+#include "utils/constants.hpp"
+
+// SnoopFilter records, for every block held by at least one cache, a presence
+// bitvector with one bit per core. Caches update it when a line becomes valid or
+// invalid, so the bus only snoops the caches whose bit is set.
+//
+// By default it is ideal: an open-addressing hash table (linear probing, backward
+// shift deletion) sized for every line of every cache to hold a different block, so
+// it never fills up and never needs back-invalidations.
+//
+// With a capacity, it models a hardware snoop filter: capacity entries in sets of
+// SNOOP_FILTER_WAYS ways, replaced LRU (by their last presence update). A block can
+// only be tracked once the entry of a full set is evicted, which the caller does by
+// back-invalidating the victim's holders (see full and victim).
+class SnoopFilter
+{
+private:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    int words;        // Presence words per block.
+    u64 mask;         // Table size - 1 (a power of two), when ideal.
+    u32 num_sets = 0; // Sets of SNOOP_FILTER_WAYS slots, 0 when ideal.
+
+    std::vector<u32> keys; // Block address + 1, 0 if the slot is empty.
+    std::vector<u64> bits; // words presence words per slot.
+    std::vector<u64> used; // Last presence update of each slot (bounded filter only).
+    u64 clock = 0;
+
+    u64 entries = 0;
+
+    size_t home(u32 block) const { return (static_cast<u64>(block) * 0x9E3779B97F4A7C15ULL >> 32) & mask; }
+
+    // find returns the slot of block, or the empty slot where it would be inserted
+    // (NONE if its set is full).
+    size_t find(u32 block) const
+    {
+        if (num_sets > 0)
+        {
+            const size_t set = static_cast<size_t>(block % num_sets) * SNOOP_FILTER_WAYS;
+            size_t empty = NONE;
+            for (size_t i = set; i < set + SNOOP_FILTER_WAYS; i++)
+            {
+                if (keys[i] == block + 1)
+                    return i;
+                if (keys[i] == 0 && empty == NONE)
+                    empty = i;
+            }
+            return empty;
+        }
+        size_t i = home(block);
+        while (keys[i] != 0 && keys[i] != block + 1)
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    // erase empties slot i, moving back the entries that probed past it.
+    void erase(size_t i)
+    {
+        if (num_sets > 0)
+        {
+            keys[i] = 0;
+            entries--;
+            return;
+        }
+        size_t j = i;
+        while (true)
+        {
+            j = (j + 1) & mask;
+            if (keys[j] == 0)
+                break;
+            // Move j into the hole unless its home lies cyclically in (i, j].
+            const size_t h = home(keys[j] - 1);
+            if (((j - h) & mask) < ((j - i) & mask))
+                continue;
+            keys[i] = keys[j];
+            std::copy(&bits[j * words], &bits[j * words] + words, &bits[i * words]);
+            i = j;
+        }
+        keys[i] = 0;
+        std::fill(&bits[i * words], &bits[i * words] + words, 0);
+        entries--;
+    }
+
+public:
+    // capacity is the number of entries of a bounded filter (a multiple of SNOOP_FILTER_WAYS),
+    // or 0 for an ideal one.
+    SnoopFilter(int num_cores, size_t lines_per_cache, size_t capacity = 0) : words((num_cores + 63) / 64)
+    {
+        size_t size = capacity;
+        if (capacity > 0)
+        {
+            num_sets = static_cast<u32>(capacity / SNOOP_FILTER_WAYS);
+            mask = 0;
+            used.assign(size, 0);
+        }
+        else
+        {
+            size = 1;
+            while (size < 2 * lines_per_cache * num_cores)
+                size *= 2;
+            mask = size - 1;
+        }
+        keys.assign(size, 0);
+        bits.assign(size * words, 0);
+    }
+
+    bool ideal() const { return num_sets == 0; }
+
+    // full returns true if block is not tracked and has no free entry: an entry must
+    // be evicted (see victim) before a cache can hold it.
+    bool full(u32 block) const { return num_sets > 0 && find(block) == NONE; }
+
+    // victim returns the block of the least recently updated entry of block's set.
+    u32 victim(u32 block) const
+    {
+        const size_t set = static_cast<size_t>(block % num_sets) * SNOOP_FILTER_WAYS;
+        size_t lru = set;
+        for (size_t i = set + 1; i < set + SNOOP_FILTER_WAYS; i++)
+            if (used[i] < used[lru])
+                lru = i;
+        return keys[lru] - 1;
+    }
+
+    // set records whether core holds block. A bounded filter must not be full for block.
+    void set(u32 block, int core, bool present)
+    {
+        const size_t i = find(block);
+        const u64 bit = 1ULL << (core % 64);
+        if (present)
+        {
+            assert(i != NONE);
+            if (keys[i] == 0)
+            {
+                keys[i] = block + 1;
+                entries++;
+            }
+            bits[i * words + core / 64] |= bit;
+            if (num_sets > 0)
+                used[i] = ++clock;
+        }
+        else if (i != NONE && keys[i] != 0)
+        {
+            bits[i * words + core / 64] &= ~bit;
+            for (int w = 0; w < words; w++)
+                if (bits[i * words + w] != 0)
+                    return;
+            erase(i);
+        }
+    }
+
+    // holders returns the presence words of block, or nullptr if no cache holds it.
+    const u64 *holders(u32 block) const
+    {
+        const size_t i = find(block);
+        return i == NONE || keys[i] == 0 ? nullptr : &bits[i * words];
+    }
+
+    int presence_words() const { return words; }
+    u64 tracked_blocks() const { return entries; }
+};
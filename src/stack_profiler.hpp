@@ -0,0 +1,210 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+#include <algorithm>
+#include "utils/trace_item.hpp"
+#include "utils/trace_loader.hpp"
+#include "utils/types.hpp"
+#include "utils/constants.hpp"
+
+// StackProfiler computes the LRU miss counts of every power-of-two cache size and
+// associativity in a single pass per set count, using Mattson stack distances.
+//
+// For a cache with S sets, an access hits in an A-way LRU cache iff fewer than A
+// distinct blocks of its set were accessed since the previous access to its block
+// (its per-set stack distance). Stack distances are computed with Olken's algorithm:
+// a Fenwick tree over access times marks the last access of every block, so the
+// distance is the number of marks after the previous access (O(log N) per access).
+//
+// Each core is profiled as a private cache without coherence traffic,
+// so misses caused by invalidations from other cores are not included.
+class StackProfiler
+{
+private:
+    int block_bytes;
+    int max_cache_size;
+    int max_assoc;
+    int max_blocks; // Number of blocks in the largest cache.
+
+    // hist[core][k][d]: accesses with per-set stack distance d for 2^k sets.
+    // The last bucket counts cold accesses and distances beyond the largest cache.
+    std::vector<std::vector<std::vector<u64>>> hist;
+    std::vector<u64> accesses;
+
+    static bool is_pow2(int v) { return v > 0 && (v & (v - 1)) == 0; }
+
+    // Distance histogram of one core's block accesses for num_sets sets, capped at cap.
+    static std::vector<u64> set_histogram(const std::vector<u32> &blocks, const std::vector<u32> &ids,
+                                          u32 num_ids, u32 num_sets, u32 cap)
+    {
+        const size_t n = blocks.size();
+
+        // Each set gets its own Fenwick tree over its local access times (1-based).
+        std::vector<u32> offset(num_sets + 1, 0);
+        for (size_t i = 0; i < n; i++)
+            offset[(blocks[i] & (num_sets - 1)) + 1]++;
+        for (u32 s = 0; s < num_sets; s++)
+            offset[s + 1] += offset[s] + 1;
+
+        std::vector<u32> tree(offset[num_sets] + 1, 0);
+        std::vector<u32> now(num_sets, 0);
+        std::vector<u32> last(num_ids, 0);
+        std::vector<u64> h(cap + 1, 0);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const u32 s = blocks[i] & (num_sets - 1);
+            u32 *t = tree.data() + offset[s];
+            const u32 len = offset[s + 1] - offset[s] - 1;
+            const u32 cur = ++now[s];
+            u32 &prev = last[ids[i]];
+
+            u32 d = cap;
+            if (prev != 0)
+            {
+                // Marks in (prev, cur): distinct blocks of the set accessed since.
+                u32 marks = 0;
+                for (u32 k = cur - 1; k > 0; k -= k & -k)
+                    marks += t[k];
+                for (u32 k = prev; k > 0; k -= k & -k)
+                    marks -= t[k];
+                d = std::min(marks, cap);
+
+                for (u32 k = prev; k <= len; k += k & -k)
+                    t[k]--;
+            }
+            h[d]++;
+
+            for (u32 k = cur; k <= len; k += k & -k)
+                t[k]++;
+            prev = cur;
+        }
+        return h;
+    }
+
+    // hits returns the hits of core c for a cache with 2^k sets and assoc ways.
+    u64 hits(int c, int k, int assoc) const
+    {
+        u64 sum = 0;
+        for (int d = 0; d < assoc; d++)
+            sum += hist[c][k][d];
+        return sum;
+    }
+
+public:
+    StackProfiler(int max_cache_size, int max_assoc, int block_size)
+        : block_bytes(block_size), max_cache_size(max_cache_size), max_assoc(max_assoc)
+    {
+        if (!is_pow2(block_size) || !is_pow2(max_cache_size) || !is_pow2(max_assoc) || max_cache_size < block_size)
+        {
+            std::cerr << "Profile needs power-of-two cache size, associativity and block size\n";
+            std::exit(2);
+        }
+        max_blocks = max_cache_size / block_size;
+    }
+
+    // profile computes the stack distance histograms of every core and set count.
+    // Cores and set counts are independent, so they are processed in parallel.
+    void profile(const std::vector<std::vector<TraceItem>> &traces)
+    {
+        const size_t cores = traces.size();
+        int set_counts = 0;
+        for (int sets = 1; sets <= max_blocks; sets *= 2)
+            set_counts++;
+
+        // Block address and dense block id of every memory access.
+        std::vector<std::vector<u32>> blocks(cores), ids(cores);
+        std::vector<u32> num_ids(cores);
+        accesses.assign(cores, 0);
+        parallel_for(cores, [&](size_t c)
+                     {
+                         blocks[c].reserve(traces[c].size());
+                         ids[c].reserve(traces[c].size());
+                         std::unordered_map<u32, u32> id_of;
+                         for (const auto &it : traces[c])
+                         {
+                             if (it.op() == Operation::Other)
+                                 continue;
+                             u32 block = it.addr / block_bytes;
+                             auto pos = id_of.try_emplace(block, static_cast<u32>(id_of.size())).first;
+                             blocks[c].push_back(block);
+                             ids[c].push_back(pos->second);
+                         }
+                         num_ids[c] = static_cast<u32>(id_of.size());
+                         accesses[c] = blocks[c].size(); });
+
+        // The fully associative pass keeps every distance up to the largest cache,
+        // the others only up to the largest associativity.
+        hist.assign(cores, std::vector<std::vector<u64>>(set_counts));
+        parallel_for(cores * set_counts, [&](size_t t)
+                     {
+                         size_t c = t / set_counts;
+                         u32 sets = 1u << (t % set_counts);
+                         u32 cap = sets == 1 ? max_blocks : std::min<u32>(max_assoc, max_blocks / sets);
+                         hist[c][t % set_counts] = set_histogram(blocks[c], ids[c], num_ids[c], sets, cap); });
+    }
+
+    void print_results(bool json) const
+    {
+        struct Row
+        {
+            int cache_size, assoc, k;
+        };
+        std::vector<Row> rows;
+        for (int size = block_bytes; size <= max_cache_size; size *= 2)
+        {
+            int blocks = size / block_bytes;
+            for (int assoc = 1; assoc <= std::min(max_assoc, blocks); assoc *= 2)
+                rows.push_back({size, assoc, __builtin_ctz(static_cast<unsigned>(blocks / assoc))});
+            if (blocks > max_assoc)
+                rows.push_back({size, blocks, 0}); // Fully associative.
+        }
+
+        if (json)
+        {
+            std::cout << "{\n";
+            std::cout << "  \"block_size\": " << block_bytes << ",\n";
+            std::cout << "  \"configs\": [\n";
+            for (size_t r = 0; r < rows.size(); r++)
+            {
+                std::cout << "    {\"cache_size\": " << rows[r].cache_size << ", \"associativity\": " << rows[r].assoc
+                          << ", \"per_core_hits\": [";
+                for (size_t c = 0; c < hist.size(); c++)
+                    std::cout << hits(c, rows[r].k, rows[r].assoc) << (c + 1 < hist.size() ? "," : "");
+                std::cout << "], \"per_core_misses\": [";
+                for (size_t c = 0; c < hist.size(); c++)
+                    std::cout << accesses[c] - hits(c, rows[r].k, rows[r].assoc) << (c + 1 < hist.size() ? "," : "");
+                std::cout << "]}" << (r + 1 < rows.size() ? ",\n" : "\n");
+            }
+            std::cout << "  ]\n";
+            std::cout << "}\n";
+        }
+        else
+        {
+            std::cout << "\n=== LRU Stack Distance Profile (block size " << block_bytes << ") ===\n";
+            std::cout << std::left << std::setw(12) << "Cache Size" << std::setw(8) << "Assoc";
+            for (size_t c = 0; c < hist.size(); c++)
+                std::cout << std::setw(22) << ("Core " + std::to_string(c) + " Misses");
+            std::cout << "\n"
+                      << std::string(20 + 22 * hist.size(), '-') << "\n";
+            for (const auto &row : rows)
+            {
+                std::cout << std::left << std::setw(12) << row.cache_size << std::setw(8) << row.assoc;
+                for (size_t c = 0; c < hist.size(); c++)
+                {
+                    u64 misses = accesses[c] - hits(c, row.k, row.assoc);
+                    std::ostringstream cell;
+                    cell << misses << " (" << std::fixed << std::setprecision(2)
+                         << (accesses[c] ? 100.0 * misses / accesses[c] : 0.0) << "%)";
+                    std::cout << std::setw(22) << cell.str();
+                }
+                std::cout << "\n";
+            }
+            std::cout << "\n";
+        }
+    }
+};
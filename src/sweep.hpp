@@ -0,0 +1,220 @@
+// sweep.hpp contains the in-process parameter sweep (./coherence --sweep),
+// the single-process counterpart of scripts/sweep.sh and scripts/json_to_csv.sh.
+#pragma once
+#include <vector>
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <filesystem>
+#include "cache_sim.hpp"
+#include "lockstep_sim.hpp"
+#include "utils/trace_item.hpp"
+#include "utils/trace_loader.hpp"
+#include "utils/binary_trace.hpp"
+#include "utils/stats.hpp"
+#include "utils/utils.hpp"
+#include "utils/constants.hpp"
+
+// -------------------
+// Sweep definitions (as in scripts/sweep.sh)
+// -------------------
+static const std::vector<std::string> SWEEP_PROTOCOLS = {"MESI", "Dragon", "MOESI"};
+static const std::vector<int> SWEEP_CACHE_SIZES = {1024, 2048, 4096, 8192, 16384};
+static const std::vector<int> SWEEP_ASSOCS = {1, 2, 4, 8, 16};
+static const std::vector<int> SWEEP_BLOCKS = {4, 8, 16, 32, 64};
+
+// SweepPoint is one row of the sweep table.
+struct SweepPoint
+{
+    std::string sweep; // Swept parameter: "cache", "assoc", "block" or "replacement".
+    SimConfig config;
+};
+
+// sweep_points returns the rows of one benchmark, in the order of scripts/sweep.sh:
+// each parameter is swept in turn while the others keep their default value.
+// The replacement policies are swept last, at the default geometry.
+inline std::vector<SweepPoint> sweep_points()
+{
+    std::vector<SweepPoint> points;
+    for (const std::string sweep : {"cache", "assoc", "block"})
+    {
+        for (const auto &protocol : SWEEP_PROTOCOLS)
+        {
+            const auto &values = sweep == "cache" ? SWEEP_CACHE_SIZES : sweep == "assoc" ? SWEEP_ASSOCS
+                                                                                          : SWEEP_BLOCKS;
+            for (int v : values)
+            {
+                SweepPoint p{sweep, {protocol, DEFAULT_CACHE_SIZE, DEFAULT_ASSOCIATIVITY, DEFAULT_BLOCK_SIZE}};
+                (sweep == "cache" ? p.config.cache_size : sweep == "assoc" ? p.config.assoc
+                                                                           : p.config.block_size) = v;
+                points.push_back(p);
+            }
+        }
+    }
+    for (const auto &protocol : SWEEP_PROTOCOLS)
+    {
+        for (const auto &replacement : REPLACEMENT_POLICIES)
+        {
+            points.push_back({"replacement", {protocol, DEFAULT_CACHE_SIZE, DEFAULT_ASSOCIATIVITY, DEFAULT_BLOCK_SIZE, replacement}});
+        }
+    }
+    return points;
+}
+
+// sweep_inputs lists the benchmarks under DEFAULT_TRACES_PATH, preferring the binary
+// traces from `make convert` when present.
+inline std::vector<std::string> sweep_inputs()
+{
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(DEFAULT_TRACES_PATH, ec))
+    {
+        std::string file = entry.path().filename().string();
+        for (const auto &ext : TRACE_EXTS)
+        {
+            std::string suffix = "_0" + ext;
+            if (file.size() > suffix.size() && file.compare(file.size() - suffix.size(), suffix.size(), suffix) == 0)
+                names.push_back(file.substr(0, file.size() - suffix.size()));
+        }
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    std::vector<std::string> inputs;
+    for (const auto &name : names)
+    {
+        std::string binary = DEFAULT_TRACES_PATH + name + "_0" + BINARY_TRACE_EXT;
+        inputs.push_back(file_exists(binary) ? binary : DEFAULT_TRACES_PATH + name + "_0.data");
+    }
+    return inputs;
+}
+
+// benchmark_name returns the name of the benchmark an input refers to, e.g.
+// "bodytrack" for "./tests/benchmark_traces/bodytrack_0.data".
+inline std::string benchmark_name(const std::string &input)
+{
+    std::string name = input.substr(input.find_last_of("/:") + 1);
+    for (const auto &ext : TRACE_EXTS)
+    {
+        std::string suffix = "_0" + ext;
+        if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+            return name.substr(0, name.size() - suffix.size());
+    }
+    if (name.size() > ZIP_EXT.size() && name.compare(name.size() - ZIP_EXT.size(), ZIP_EXT.size(), ZIP_EXT) == 0)
+        name.resize(name.size() - ZIP_EXT.size());
+    if (name.size() > 5 && name.compare(name.size() - 5, 5, "_four") == 0)
+        name.resize(name.size() - 5);
+    return name;
+}
+
+// run_sweep simulates every sweep point of every input and prints one CSV (or JSON) table.
+//
+// Each benchmark is parsed once and its traces are shared read-only by all of its
+// simulations, which run concurrently on a pool of threads. Points that describe the
+// same configuration (the defaults appear in every sweep) are simulated once.
+//
+// With lockstep, the runs are instead split into one group per thread, and each group
+// is simulated by a LockstepSim from a single streaming pass over the traces (see
+// LockstepSim for its memory use).
+inline void run_sweep(std::vector<std::string> inputs, bool json, bool lockstep = false)
+{
+    if (inputs.empty())
+        inputs = sweep_inputs();
+    if (inputs.empty())
+    {
+        std::cerr << "No traces found in " << DEFAULT_TRACES_PATH << "\n";
+        std::exit(2);
+    }
+
+    const auto points = sweep_points();
+    std::map<std::tuple<std::string, int, int, int, std::string>, size_t> run_of;
+    std::vector<size_t> point_run(points.size());
+    std::vector<const SimConfig *> runs;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        const SimConfig &c = points[i].config;
+        auto [it, added] = run_of.try_emplace({c.protocol, c.cache_size, c.assoc, c.block_size, c.replacement}, runs.size());
+        if (added)
+            runs.push_back(&c);
+        point_run[i] = it->second;
+    }
+
+    if (json)
+        std::cout << "[\n";
+    else
+        std::cout << "Problem,Protocol,Sweep," << Stats::csv_header() << "\n";
+
+    bool first = true;
+    for (const auto &input : inputs)
+    {
+        const std::string name = benchmark_name(input);
+        const auto paths = resolve_traces(input);
+        std::vector<std::string> results(runs.size());
+        auto render = [json](const Stats &stats)
+        {
+            std::ostringstream out;
+            if (json)
+                stats.print_results(true, out);
+            else
+                stats.print_csv_row(out);
+            return out.str();
+        };
+
+        if (lockstep)
+        {
+            const size_t groups = std::min(runs.size(), parse_threads());
+            parallel_for(groups, [&](size_t g)
+                         {
+                             std::vector<size_t> members;
+                             std::vector<SimConfig> configs;
+                             for (size_t r = g; r < runs.size(); r += groups)
+                             {
+                                 members.push_back(r);
+                                 configs.push_back(*runs[r]);
+                             }
+                             LockstepSim sim(configs, paths);
+                             sim.run();
+                             for (size_t i = 0; i < members.size(); i++)
+                                 results[members[i]] = render(sim.get_stats(i)); });
+        }
+        else
+        {
+            const auto items = load_traces_parallel(paths);
+            parallel_for(runs.size(), [&](size_t r)
+                         {
+                             CacheSim sim(*runs[r], static_cast<int>(paths.size()));
+                             sim.share_traces(items);
+                             sim.run();
+                             results[r] = render(sim.get_stats()); });
+        }
+
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            const std::string &result = results[point_run[i]];
+            if (!json)
+            {
+                std::cout << name << "," << points[i].config.protocol << "," << points[i].sweep << "," << result;
+                continue;
+            }
+
+            // Nest the result object of the run, indented one level deeper.
+            std::cout << (first ? "" : ",\n")
+                      << "  {\"benchmark\": \"" << name << "\", \"sweep\": \"" << points[i].sweep << "\", \"results\": ";
+            for (size_t pos = 0; pos < result.size();)
+            {
+                size_t nl = result.find('\n', pos);
+                std::cout << (pos == 0 ? "" : "  ") << result.substr(pos, nl - pos);
+                if (nl + 1 < result.size())
+                    std::cout << "\n";
+                pos = nl + 1;
+            }
+            std::cout << "}";
+            first = false;
+        }
+    }
+    if (json)
+        std::cout << "\n]\n";
+}
@@ -0,0 +1,51 @@
+// Trace converter entrypoint: text traces to the binary trace format.
+//
+// CLI
+//   ./trace_convert <trace.data>...
+//
+// Each "<name>.data" is written next to the input as "<name>.bin",
+// which ./coherence reads directly (e.g. ./coherence MESI bodytrack_0.bin 4096 2 32).
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "utils/trace_item.hpp"
+#include "utils/binary_trace.hpp"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <trace.data>...\n";
+        return 2;
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string in = argv[i];
+        std::string out = in;
+        auto dot = out.rfind('.');
+        if (dot != std::string::npos && out.find('/', dot) == std::string::npos)
+            out.erase(dot);
+        out += BINARY_TRACE_EXT;
+
+        auto items = parse_trace(in);
+        write_binary_trace(out, items);
+
+        // Round trip, so that a broken conversion is never used for simulation.
+        auto decoded = read_binary_trace(out);
+        bool same = decoded.size() == items.size();
+        for (size_t k = 0; same && k < items.size(); k++)
+        {
+            same = decoded[k].op_gap == items[k].op_gap && decoded[k].addr == items[k].addr;
+        }
+        if (!same)
+        {
+            std::cerr << "Round trip failed: " << out << "\n";
+            return 2;
+        }
+        std::cout << in << " -> " << out << " (" << items.size() << " memory operations)\n";
+    }
+
+    return 0;
+}
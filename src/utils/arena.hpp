@@ -0,0 +1,56 @@
+// arena.hpp contains the bump allocator backing the caches of a simulation.
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <memory>
+#include <cassert>
+#include <type_traits>
+#include "constants.hpp"
+
+// Arena is one zeroed, host cache line aligned allocation, carved into arrays.
+// Every array starts on its own host cache line.
+class Arena
+{
+private:
+    struct Free
+    {
+        void operator()(unsigned char *p) const { ::operator delete[](p, std::align_val_t(HOST_CACHE_LINE_BYTES)); }
+    };
+
+    std::unique_ptr<unsigned char[], Free> base;
+    size_t capacity = 0;
+    size_t used = 0;
+
+public:
+    // bytes_for returns the arena bytes taken by an array of n T.
+    template <typename T>
+    static constexpr size_t bytes_for(size_t n)
+    {
+        return (n * sizeof(T) + HOST_CACHE_LINE_BYTES - 1) / HOST_CACHE_LINE_BYTES * HOST_CACHE_LINE_BYTES;
+    }
+
+    explicit Arena(size_t bytes)
+        : base(static_cast<unsigned char *>(::operator new[](bytes, std::align_val_t(HOST_CACHE_LINE_BYTES)))),
+          capacity(bytes)
+    {
+        std::memset(base.get(), 0, bytes);
+    }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // take returns the next n value-initialized T. T must be trivially destructible.
+    template <typename T>
+    T *take(size_t n)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "arena arrays are never destroyed");
+        size_t bytes = bytes_for<T>(n);
+        assert(bytes <= capacity - used);
+        T *p = reinterpret_cast<T *>(base.get() + used);
+        used += bytes;
+        for (size_t i = 0; i < n; i++)
+            new (p + i) T();
+        return p;
+    }
+};
@@ -0,0 +1,210 @@
+// binary_trace.hpp contains a compact binary encoding of the text traces.
+//
+// Layout (all integers little endian):
+//   magic   "CTRB" (4 bytes)
+//   version u32
+//   count   u64, number of records
+//   records count varints (LEB128)
+//
+// Each record is a single varint (payload << 2) | label, where label is the
+// text label (0 load, 1 store, 2 other). For compute records the payload is
+// the compute gap in cycles. For memory records the payload is the zigzag
+// encoded difference from the previous memory address of the same trace.
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include "types.hpp"
+#include "mapped_file.hpp"
+#include "trace_item.hpp"
+
+static constexpr char BINARY_TRACE_MAGIC[4] = {'C', 'T', 'R', 'B'};
+static constexpr u32 BINARY_TRACE_VERSION = 1;
+static constexpr size_t BINARY_TRACE_HEADER_BYTES = 16;
+static const std::string BINARY_TRACE_EXT = ".bin";
+
+// is_binary_trace_path checks if the path names a binary trace (by extension).
+inline bool is_binary_trace_path(const std::string &path)
+{
+    return path.size() > BINARY_TRACE_EXT.size() &&
+           path.compare(path.size() - BINARY_TRACE_EXT.size(), BINARY_TRACE_EXT.size(), BINARY_TRACE_EXT) == 0;
+}
+
+inline u64 zigzag_encode(long long v) { return (static_cast<u64>(v) << 1) ^ static_cast<u64>(v >> 63); }
+inline long long zigzag_decode(u64 v) { return static_cast<long long>(v >> 1) ^ -static_cast<long long>(v & 1); }
+
+inline void put_varint(std::string &buf, u64 v)
+{
+    while (v >= 0x80)
+    {
+        buf.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    buf.push_back(static_cast<char>(v));
+}
+
+// get_varint decodes one varint at p, returns false if the input is truncated.
+inline bool get_varint(const unsigned char *&p, const unsigned char *end, u64 &v)
+{
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7)
+    {
+        unsigned char b = *p++;
+        v |= static_cast<u64>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+inline void put_u32_le(std::string &buf, u32 v)
+{
+    for (int i = 0; i < 4; i++)
+        buf.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+}
+
+inline void put_u64_le(std::string &buf, u64 v)
+{
+    for (int i = 0; i < 8; i++)
+        buf.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+}
+
+inline u64 get_le(const unsigned char *p, int bytes)
+{
+    u64 v = 0;
+    for (int i = 0; i < bytes; i++)
+        v |= static_cast<u64>(p[i]) << (8 * i);
+    return v;
+}
+
+// write_binary_trace encodes the trace items into a binary trace file.
+// The compute gap of an item is written as a compute record in front of it.
+inline void write_binary_trace(const std::string &path, const std::vector<TraceItem> &items)
+{
+    std::string buf;
+    buf.reserve(BINARY_TRACE_HEADER_BYTES + items.size() * 3);
+    buf.append(BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC));
+    put_u32_le(buf, BINARY_TRACE_VERSION);
+    put_u64_le(buf, 0); // Record count, filled in below.
+
+    u64 count = 0;
+    u32 prev_addr = 0;
+    for (const auto &it : items)
+    {
+        if (it.gap() > 0 || it.op() == Operation::Other)
+        {
+            put_varint(buf, (it.gap() << 2) | static_cast<u64>(Operation::Other));
+            count++;
+        }
+        if (it.op() != Operation::Other)
+        {
+            u64 payload = zigzag_encode(static_cast<long long>(it.addr) - static_cast<long long>(prev_addr));
+            prev_addr = it.addr;
+            put_varint(buf, (payload << 2) | static_cast<u64>(it.op()));
+            count++;
+        }
+    }
+
+    std::string header;
+    put_u64_le(header, count);
+    buf.replace(8, 8, header);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out || !out.write(buf.data(), static_cast<std::streamsize>(buf.size())))
+    {
+        std::cerr << "Cannot write: " << path << "\n";
+        std::exit(2);
+    }
+}
+
+// read_binary_header validates the header at p and returns the record count.
+// p is advanced to the first record.
+inline u64 read_binary_header(const unsigned char *&p, const unsigned char *end, const std::string &path)
+{
+    if (end - p < static_cast<long>(BINARY_TRACE_HEADER_BYTES) || std::memcmp(p, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC)) != 0)
+    {
+        std::cerr << "Not a binary trace: " << path << "\n";
+        std::exit(2);
+    }
+    u32 version = static_cast<u32>(get_le(p + 4, 4));
+    if (version != BINARY_TRACE_VERSION)
+    {
+        std::cerr << "Unsupported binary trace version " << version << " in " << path << "\n";
+        std::exit(2);
+    }
+    u64 count = get_le(p + 8, 8);
+    p += BINARY_TRACE_HEADER_BYTES;
+
+    // Every record takes at least one byte, which bounds a corrupt count.
+    if (count > static_cast<u64>(end - p))
+    {
+        std::cerr << "Truncated binary trace: " << path << "\n";
+        std::exit(2);
+    }
+    return count;
+}
+
+// decode_binary_records decodes records at p until remaining reaches 0 or out holds
+// out_limit items. remaining, prev_addr and folder carry the decoding state across calls.
+inline void decode_binary_records(const unsigned char *&p, const unsigned char *end, u64 &remaining, u32 &prev_addr,
+                                  const std::string &path, std::vector<TraceItem> &out, TraceFolder &folder,
+                                  size_t out_limit = SIZE_MAX)
+{
+    for (; remaining > 0 && out.size() < out_limit; remaining--)
+    {
+        u64 v = 0;
+        if (!get_varint(p, end, v))
+        {
+            std::cerr << "Truncated binary trace: " << path << "\n";
+            std::exit(2);
+        }
+
+        u64 payload = v >> 2;
+        switch (v & 3)
+        {
+        case 0:
+        case 1:
+            prev_addr = static_cast<u32>(prev_addr + zigzag_decode(payload));
+            folder.add(out, static_cast<Operation>(v & 3), prev_addr);
+            break;
+        case 2:
+            folder.add(out, Operation::Other, static_cast<u32>(payload));
+            break;
+        default:
+            std::cerr << "Invalid record label in " << path << "\n";
+            std::exit(2);
+        }
+    }
+}
+
+// read_binary_trace decodes a binary trace file into the same trace items
+// that parse_trace returns for the text trace it was converted from.
+inline std::vector<TraceItem> read_binary_trace(const std::string &path)
+{
+    MappedFile file(path);
+    const auto *p = reinterpret_cast<const unsigned char *>(file.begin());
+    const auto *end = reinterpret_cast<const unsigned char *>(file.end());
+
+    u64 count = read_binary_header(p, end, path);
+
+    std::vector<TraceItem> out;
+    out.reserve(count);
+    u32 prev_addr = 0;
+    TraceFolder folder;
+    decode_binary_records(p, end, count, prev_addr, path, out, folder);
+    folder.flush(out);
+
+    return out;
+}
+
+// load_trace reads a binary trace or parses a text trace (on disk or in a zip archive),
+// depending on the path.
+inline std::vector<TraceItem> load_trace(const std::string &path)
+{
+    std::string archive, member;
+    if (split_zip_path(path, archive, member))
+        return parse_zip_trace(path);
+    return is_binary_trace_path(path) ? read_binary_trace(path) : parse_trace(path);
+}
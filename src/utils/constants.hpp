@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <cstddef>
 
 // -------------------
 // Tunable constants
@@ -7,17 +8,32 @@
 static constexpr int CYCLE_HIT = 1;               // L1 hit latency (cycles) — given
 static constexpr int CYCLE_MEM_BLOCK_FETCH = 100; // fetch a block from memory — given
 static constexpr int CYCLE_WRITEBACK_DIRTY = 100; // dirty writeback on eviction — given
+static constexpr int CYCLE_L2_HIT = 10;           // private L2 lookup latency (cycles)
+static constexpr int CYCLE_LLC_HIT = 30;          // shared LLC lookup latency (cycles)
 static constexpr int WORD_BYTES = 4;              // word size is 4 bytes.
+static constexpr size_t HYBRID_REPORT_BLOCKS = 8; // blocks listed in the Hybrid protocol's wasted update report.
+static constexpr int MSG_HEADER_BYTES = 8;        // header (command and address) of a directory network message.
+static constexpr size_t SNOOP_FILTER_WAYS = 8;    // associativity of a bounded snoop filter.
 
 // -------------------
 // CLI Defaults
 // -------------------
-static constexpr int DEFAULT_CACHE_SIZE = 4096; // 4KB cache size
-static constexpr int DEFAULT_ASSOCIATIVITY = 2; // 2-way set associative cache
-static constexpr int DEFAULT_BLOCK_SIZE = 32;   // 32 byte block size
+static constexpr int DEFAULT_CACHE_SIZE = 4096;           // 4KB cache size
+static constexpr int DEFAULT_ASSOCIATIVITY = 2;           // 2-way set associative cache
+static constexpr int DEFAULT_BLOCK_SIZE = 32;             // 32 byte block size
+static const std::string DEFAULT_REPLACEMENT = "LRU";     // true LRU replacement
+static constexpr int DEFAULT_BUS_SLOTS = 0;               // pipelined bus (no split-transaction slots)
+static constexpr int DEFAULT_HOP_LATENCY = 10;            // cycles per network hop (directory protocol)
+static constexpr int DEFAULT_UPDATE_THRESHOLD = 4;        // updates received without an access before self-invalidating (Hybrid protocol)
+static const std::string DEFAULT_INCLUSION = "inclusive"; // inclusion policy of the L2 and LLC
 
 // -------------------
 // Trace files configurations
 // -------------------
 static const std::string DEFAULT_TRACES_PATH = "./tests/benchmark_traces/"; // Path to where the traces are stored.
-static constexpr int NUM_OF_CORES = 4;                                      // The number of cores in the simulation. Supports 1 to 4.
+static const std::string DEFAULT_BENCHMARKS_PATH = "./tests/benchmark/";      // Path to where the zipped traces are stored.
+
+// -------------------
+// Host configuration
+// -------------------
+static constexpr size_t HOST_CACHE_LINE_BYTES = 64; // Cache line size of the machine running the simulator.
@@ -0,0 +1,92 @@
+// event_queue.hpp contains the time-ordered event queue of the simulation kernel.
+#pragma once
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "types.hpp"
+
+// EventQueue is a d-ary min-heap of events ordered by time, then by payload
+// (e.g. the component posting the event), so simultaneous events are handled
+// in a deterministic order. push and pop take O(log N) for N pending events.
+template <typename T, int D = 4>
+class EventQueue
+{
+public:
+    struct Event
+    {
+        u64 time;
+        T payload;
+
+        bool operator<(const Event &other) const
+        {
+            return time != other.time ? time < other.time : payload < other.payload;
+        }
+    };
+
+private:
+    std::vector<Event> heap;
+
+    void sift_up(size_t i)
+    {
+        Event e = std::move(heap[i]);
+        while (i > 0)
+        {
+            size_t parent = (i - 1) / D;
+            if (!(e < heap[parent]))
+                break;
+            heap[i] = std::move(heap[parent]);
+            i = parent;
+        }
+        heap[i] = std::move(e);
+    }
+
+    void sift_down(size_t i)
+    {
+        Event e = std::move(heap[i]);
+        const size_t n = heap.size();
+        while (true)
+        {
+            size_t first = i * D + 1;
+            if (first >= n)
+                break;
+            size_t best = first;
+            for (size_t k = first + 1; k < std::min(first + D, n); k++)
+                if (heap[k] < heap[best])
+                    best = k;
+            if (!(heap[best] < e))
+                break;
+            heap[i] = std::move(heap[best]);
+            i = best;
+        }
+        heap[i] = std::move(e);
+    }
+
+public:
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    void clear() { heap.clear(); }
+
+    // top returns the earliest event.
+    const Event &top() const { return heap.front(); }
+
+    void push(u64 time, T payload)
+    {
+        heap.push_back({time, std::move(payload)});
+        sift_up(heap.size() - 1);
+    }
+
+    void pop()
+    {
+        heap.front() = std::move(heap.back());
+        heap.pop_back();
+        if (!heap.empty())
+            sift_down(0);
+    }
+
+    // reschedule moves the earliest event to a later time.
+    void reschedule_top(u64 time)
+    {
+        heap.front().time = time;
+        sift_down(0);
+    }
+};
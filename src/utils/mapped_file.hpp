@@ -0,0 +1,80 @@
+// mapped_file.hpp contains a read-only memory mapping of a file.
+#pragma once
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// MappedFile maps a whole file read-only into memory for in-place scanning.
+// The mapping is released when the object goes out of scope.
+class MappedFile
+{
+private:
+    const char *ptr = nullptr;
+    size_t len = 0;
+    size_t released = 0; // Bytes at the front of the mapping already dropped from memory.
+
+public:
+    explicit MappedFile(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            std::cerr << "Cannot open: " << path << "\n";
+            std::exit(2);
+        }
+
+        struct stat sb{};
+        if (::fstat(fd, &sb) != 0)
+        {
+            ::close(fd);
+            std::cerr << "Cannot stat: " << path << "\n";
+            std::exit(2);
+        }
+
+        len = static_cast<size_t>(sb.st_size);
+        if (len > 0)
+        {
+            void *p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                ::close(fd);
+                std::cerr << "Cannot mmap: " << path << "\n";
+                std::exit(2);
+            }
+            // The trace is scanned front to back exactly once.
+            ::madvise(p, len, MADV_SEQUENTIAL);
+            ptr = static_cast<const char *>(p);
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile()
+    {
+        if (ptr != nullptr)
+            ::munmap(const_cast<char *>(ptr), len);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // release_before drops the whole pages in front of p from resident memory,
+    // once they have been consumed. The data can still be read (it is paged in again).
+    void release_before(const char *p)
+    {
+        static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        size_t upto = (static_cast<size_t>(p - ptr) / page) * page;
+        if (upto > released)
+        {
+            ::madvise(const_cast<char *>(ptr) + released, upto - released, MADV_DONTNEED);
+            released = upto;
+        }
+    }
+
+    const char *begin() const { return ptr; }
+    const char *end() const { return ptr + len; }
+    size_t size() const { return len; }
+};
@@ -0,0 +1,116 @@
+// simd_parse.hpp contains the vectorized building blocks of the trace parser.
+//
+// Newlines and hex digits are classified 64 bytes at a time (AVX2 when compiled
+// with -mavx2, otherwise SSE2), and the digits of a record are converted
+// 8 nibbles at a time in a 64-bit register (SWAR).
+// Other targets use the scalar equivalents.
+#pragma once
+#include <cstring>
+#include <cstddef>
+#include "types.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Bytes classified per block, and bytes that must stay readable past a block
+// (the digits of a record are read 8 bytes at a time).
+static constexpr size_t SIMD_BLOCK_BYTES = 64;
+static constexpr size_t SIMD_SLACK_BYTES = 16;
+
+// The SWAR conversion assumes little endian byte order.
+static constexpr bool SIMD_PARSE_ENABLED = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+// newline_mask64 returns a bitmask of the '\n' bytes in p[0, 64).
+inline u64 newline_mask64(const char *p)
+{
+#if defined(__AVX2__)
+    const __m256i nl = _mm256_set1_epi8('\n');
+    u64 lo = static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), nl)));
+    u64 hi = static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32)), nl)));
+    return lo | (hi << 32);
+#elif defined(__SSE2__)
+    const __m128i nl = _mm_set1_epi8('\n');
+    u64 mask = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * i));
+        mask |= static_cast<u64>(static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)))) << (16 * i);
+    }
+    return mask;
+#else
+    u64 mask = 0;
+    for (int i = 0; i < 64; i++)
+        mask |= static_cast<u64>(p[i] == '\n') << i;
+    return mask;
+#endif
+}
+
+// hex_digit_mask64 returns a bitmask of the hex digit bytes in p[0, 64).
+inline u64 hex_digit_mask64(const char *p)
+{
+#if defined(__AVX2__)
+    u64 mask = 0;
+    for (int i = 0; i < 2; i++)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32 * i));
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+        __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+        mask |= static_cast<u64>(static_cast<u32>(_mm256_movemask_epi8(_mm256_or_si256(digit, alpha)))) << (32 * i);
+    }
+    return mask;
+#elif defined(__SSE2__)
+    u64 mask = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * i));
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+        mask |= static_cast<u64>(static_cast<u32>(_mm_movemask_epi8(_mm_or_si128(digit, alpha)))) << (16 * i);
+    }
+    return mask;
+#else
+    u64 mask = 0;
+    for (int i = 0; i < 64; i++)
+    {
+        char c = p[i], l = static_cast<char>(c | 0x20);
+        mask |= static_cast<u64>((c >= '0' && c <= '9') || (l >= 'a' && l <= 'f')) << i;
+    }
+    return mask;
+#endif
+}
+
+// parse_record_fast parses a canonical "<label> 0x<1 to 8 hex digits>" record
+// of len bytes (without the newline), given the hex digit mask of its bytes
+// (bit i set if line[i] is a hex digit). 12 bytes must be readable at line.
+// Returns false for anything else, which is left to the scalar parser.
+inline bool parse_record_fast(const char *line, size_t len, u64 hex_digits, int &label, u32 &value)
+{
+    if (len < 5 || len > 12 || line[1] != ' ' || line[2] != '0' || (line[3] | 0x20) != 'x')
+        return false;
+    label = line[0] - '0';
+    if (label < 0 || label > 2)
+        return false;
+
+    const size_t n = len - 4;
+    const u64 want = ((1ULL << n) - 1) << 4;
+    if ((hex_digits & want) != want)
+        return false;
+
+    // Convert every digit byte into its nibble ('a'-'f' have bit 6 set).
+    u64 x;
+    std::memcpy(&x, line + 4, sizeof(x));
+    if (n < 8)
+        x &= (1ULL << (8 * n)) - 1;
+    x = (x & 0x0F0F0F0F0F0F0F0FULL) + ((x & 0x4040404040404040ULL) >> 6) * 9;
+
+    // Most significant digit first: right-align the digits, then pack adjacent nibbles.
+    x = __builtin_bswap64(x) >> (8 * (8 - n));
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    value = static_cast<u32>(x);
+    return true;
+}
@@ -0,0 +1,36 @@
+// simd_tags.hpp contains the vectorized tag comparison of the cache lookup.
+//
+// The tags of a set are compared 8 ways at a time with AVX2 (when compiled with
+// -mavx2), otherwise 4 ways at a time with SSE2. Other targets use a scalar loop.
+#pragma once
+#include "types.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// match_tags returns a bitmask of the ways w in [0, n) with tags[w] == tag (n <= 64).
+inline u64 match_tags(const u32 *tags, int n, u32 tag)
+{
+    u64 mask = 0;
+    int w = 0;
+#if defined(__AVX2__)
+    const __m256i want8 = _mm256_set1_epi32(static_cast<int>(tag));
+    for (; w + 8 <= n; w += 8)
+    {
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(tags + w)), want8);
+        mask |= static_cast<u64>(static_cast<u32>(_mm256_movemask_ps(_mm256_castsi256_ps(eq)))) << w;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i want4 = _mm_set1_epi32(static_cast<int>(tag));
+    for (; w + 4 <= n; w += 4)
+    {
+        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(tags + w)), want4);
+        mask |= static_cast<u64>(static_cast<u32>(_mm_movemask_ps(_mm_castsi128_ps(eq)))) << w;
+    }
+#endif
+    for (; w < n; w++)
+        mask |= static_cast<u64>(tags[w] == tag) << w;
+    return mask;
+}
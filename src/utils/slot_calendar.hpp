@@ -0,0 +1,118 @@
+// slot_calendar.hpp contains the sliding-window bitmap of reserved bus cycles.
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include "types.hpp"
+
+// SlotCalendar records which cycles are reserved, one bit per cycle.
+//
+// Only a window of cycles starting at floor() is kept, in a ring of 64-bit words
+// indexed by the absolute word number modulo the ring size. Cycles before the floor
+// are retired with retire_before once no request can ask for them anymore, so the
+// ring stays as large as the span of outstanding reservations. If a reservation
+// falls past the end of the window, the ring doubles.
+//
+// The searches scan a whole word of cycles at a time.
+class SlotCalendar
+{
+private:
+    std::vector<u64> ring; // Size is a power of two.
+    u64 base_word = 0;     // Absolute word number of the first cycle of the window.
+
+    u64 &word(u64 w) { return ring[w & (ring.size() - 1)]; }
+
+    // bits returns word w, or no reservations past the end of the window.
+    u64 bits(u64 w) const { return w - base_word < ring.size() ? ring[w & (ring.size() - 1)] : 0; }
+
+    // grow doubles the ring, moving the words of the window to their new slots.
+    void grow()
+    {
+        std::vector<u64> bigger(ring.size() * 2, 0);
+        for (u64 w = base_word; w < base_word + ring.size(); w++)
+            bigger[w & (bigger.size() - 1)] = word(w);
+        ring.swap(bigger);
+    }
+
+public:
+    explicit SlotCalendar(size_t window_cycles = 4096) : ring(std::max<size_t>(1, window_cycles / 64), 0)
+    {
+        while (ring.size() & (ring.size() - 1))
+            ring.push_back(0);
+    }
+
+    // floor returns the first cycle that is still tracked.
+    u64 floor() const { return base_word * 64; }
+
+    // retire_before drops the cycles before cycle.
+    void retire_before(u64 cycle)
+    {
+        const u64 w_end = cycle / 64;
+        if (w_end <= base_word)
+            return;
+        if (w_end - base_word >= ring.size())
+            std::fill(ring.begin(), ring.end(), 0);
+        else
+            for (u64 w = base_word; w < w_end; w++)
+                word(w) = 0;
+        base_word = w_end;
+    }
+
+    // first_free returns the first free cycle at or after cycle.
+    u64 first_free(u64 cycle) const
+    {
+        assert(cycle >= floor());
+        u64 w = cycle / 64;
+        u64 free = ~bits(w) & (~0ULL << (cycle % 64));
+        while (free == 0)
+            free = ~bits(++w);
+        return w * 64 + __builtin_ctzll(free);
+    }
+
+    // first_busy returns the first reserved cycle in [cycle, end), or end if there is none.
+    u64 first_busy(u64 cycle, u64 end) const
+    {
+        assert(cycle >= floor());
+        u64 w = cycle / 64;
+        u64 busy = bits(w) & (~0ULL << (cycle % 64));
+        while (busy == 0 && (w + 1) * 64 < end)
+            busy = bits(++w);
+        return busy == 0 ? end : std::min(end, w * 64 + __builtin_ctzll(busy));
+    }
+
+    // first_free_run returns the first cycle at or after cycle that starts len free cycles.
+    u64 first_free_run(u64 cycle, u64 len) const
+    {
+        while (true)
+        {
+            cycle = first_free(cycle);
+            const u64 busy = first_busy(cycle, cycle + len);
+            if (busy == cycle + len)
+                return cycle;
+            cycle = busy;
+        }
+    }
+
+    // mark reserves the len cycles starting at cycle.
+    void mark(u64 cycle, u64 len = 1)
+    {
+        assert(cycle >= floor());
+        for (u64 c = cycle; c < cycle + len;)
+        {
+            const u64 w = c / 64;
+            while (w - base_word >= ring.size())
+                grow();
+            const u64 n = std::min<u64>(64 - c % 64, cycle + len - c);
+            word(w) |= (n == 64 ? ~0ULL : ((1ULL << n) - 1)) << (c % 64);
+            c += n;
+        }
+    }
+
+    // reserve marks the first free cycle at or after cycle and returns it.
+    u64 reserve(u64 cycle)
+    {
+        const u64 free = first_free(cycle);
+        mark(free);
+        return free;
+    }
+};
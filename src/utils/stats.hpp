@@ -4,10 +4,15 @@
 #include <iomanip>
 #include <algorithm>
 #include <string>
+#include <cmath>
+#include <unordered_map>
 #include "types.hpp"
 #include "trace_item.hpp"
+#include "constants.hpp"
 
-struct CoreStats
+// CoreStats holds the counters of one core. Each core's counters start on their own
+// host cache line, so threads updating different cores never false-share.
+struct alignas(HOST_CACHE_LINE_BYTES) CoreStats
 {
     u64 exec_cycles = 0;
     u64 compute_cycles = 0;
@@ -25,6 +30,32 @@ struct CoreStats
     u64 shared_accesses = 0;
 };
 
+// LevelStats holds the counters of one cache level below the L1s.
+struct LevelStats
+{
+    std::string name;
+    u64 accesses = 0;                // L1 misses (and, below the L2, L2 misses) looked up in the level.
+    u64 hits = 0;
+    u64 misses = 0;
+    u64 latency_cycles = 0;          // Latency of the lookups, including the levels below on a miss.
+    u64 back_invalidations = 0;      // Copies in the levels above invalidated by this level's evictions.
+    u64 writebacks = 0;              // Dirty blocks this level evicted to the level below.
+    u64 coherence_invalidations = 0; // Private copies dropped because another core wrote the block.
+    u64 remote_flushes = 0;          // Dirty private copies written back for another core's miss.
+    std::vector<u64> bank_accesses;
+};
+
+// BlockModes holds the writes and updates of one block under the Hybrid protocol.
+struct BlockModes
+{
+    u64 update_writes = 0;    // Writes broadcast as a BusUpd (update mode).
+    u64 local_writes = 0;     // Writes without other holders (invalidate mode).
+    u64 updates_received = 0; // Updates delivered to other caches.
+    u64 useful_updates = 0;   // Updates read by their receiver before the next one.
+};
+
+// Stats records the statistics of one simulation. It is owned by the CacheSim,
+// and passed by reference to its caches, bus and protocols.
 class Stats
 {
 private:
@@ -35,24 +66,70 @@ private:
     u64 overall_bus_invalidations = 0;    // Count upon BusRdX sent on the bus, assume that invalidation counts even if no sharers.
     u64 overall_bus_updates = 0;          // Count upon BusUpd sent on the bus, assume that update counts even if no sharers.
 
+    // Split-transaction bus (only when bus_slots > 0).
+    u64 bus_transactions = 0;
+    u64 bus_request_queue_cycles = 0;  // Cycles requests waited for a slot and the address bus.
+    u64 bus_response_queue_cycles = 0; // Cycles responses waited for the data bus.
+    u64 bus_max_queue_cycles = 0;      // Longest total wait of a transaction.
+    u64 bus_data_cycles = 0;           // Cycles the data bus was transferring.
+
+    // Snoop filter (only reported when snoop_filter is set).
+    u64 snoop_broadcasts = 0;    // Bus transactions looked up in the filter.
+    u64 snoops_sent = 0;         // Snoops sent to caches holding the block.
+    u64 snoops_filtered = 0;     // Snoops a broadcast would have sent to caches without the block.
+    u64 snoop_filter_blocks = 0; // Most blocks tracked at once.
+    u64 snoop_filter_capacity = 0;           // Entries of a bounded filter, 0 if it is ideal.
+    u64 snoop_filter_evictions = 0;          // Entries evicted from a full filter.
+    u64 snoop_filter_back_invalidations = 0; // Cache lines invalidated by those evictions.
+
+    // Migratory sharing detector (only reported when migratory is set).
+    u64 migratory_detections = 0;     // Blocks classified as migratory.
+    u64 migratory_reads = 0;          // Read misses served as exclusive.
+    u64 migratory_mispredictions = 0; // Exclusive reads not followed by a write, declassifying the block.
+    u64 migratory_saved = 0;          // Upgrades (BusRdX transactions) saved by an exclusive read.
+
+    // Cache levels below the L1s (only reported if there are any).
+    std::vector<LevelStats> levels;
+    std::string inclusion_name;
+
+    // Memory fetches (the forwarder counters are only reported for the MESIF protocol).
+    u64 memory_fetches = 0;        // Blocks fetched from main memory (or the levels below the L1s) on a miss.
+    u64 shared_memory_fetches = 0; // MESIF: fetches of blocks other caches held, without a forwarder.
+    u64 forwarded_reads = 0;       // MESIF: clean blocks sent cache-to-cache by the forwarder on a read.
+
+    // Hybrid update/invalidate (only reported for the Hybrid protocol).
+    u64 self_invalidations = 0;
+    std::unordered_map<u32, BlockModes> block_modes; // Indexed by block address.
+
+    // Directory network (only reported for the Directory protocol).
+    u64 dir_requests = 0;     // Requests sent to a home node.
+    u64 dir_indirections = 0; // Requests the home node forwarded to other caches (3 hops).
+    u64 dir_forwards = 0;     // Read requests forwarded to a holder.
+    u64 dir_invalidations = 0;
+    u64 dir_acks = 0;
+    u64 dir_messages = 0;
+    u64 dir_network_bytes = 0;
+
     int block_size = 0;
     int cache_size = 0;
     int association = 0;
+    int bus_slots = 0;
+    bool snoop_filter = false;
+    bool migratory = false;
     std::string protocol_name;
-
-    Stats() = default;
+    std::string replacement_name;
 
     template <typename T>
-    void print_array_json(const std::string &key, const std::vector<T> &vals, bool comma = true) const
+    void print_array_json(std::ostream &out, const std::string &key, const std::vector<T> &vals, bool comma = true) const
     {
-        std::cout << "  \"" << key << "\": [";
+        out << "  \"" << key << "\": [";
         for (size_t i = 0; i < vals.size(); ++i)
         {
-            std::cout << vals[i];
+            out << vals[i];
             if (i < vals.size() - 1)
-                std::cout << ",";
+                out << ",";
         }
-        std::cout << "]" << (comma ? ",\n" : "\n");
+        out << "]" << (comma ? ",\n" : "\n");
     }
 
     template <typename F>
@@ -65,142 +142,469 @@ private:
         return result;
     }
 
-    static Stats &instance()
+    // hybrid_totals returns the sum of the block modes, and the number of blocks mostly written in update mode.
+    std::pair<BlockModes, u64> hybrid_totals() const
+    {
+        BlockModes total;
+        u64 update_blocks = 0;
+        for (const auto &[block, m] : block_modes)
+        {
+            total.update_writes += m.update_writes;
+            total.local_writes += m.local_writes;
+            total.updates_received += m.updates_received;
+            total.useful_updates += m.useful_updates;
+            update_blocks += m.update_writes > m.local_writes;
+        }
+        return {total, update_blocks};
+    }
+
+    // most_wasted_blocks returns the blocks with the most useless updates, most first.
+    std::vector<std::pair<u32, BlockModes>> most_wasted_blocks() const
+    {
+        std::vector<std::pair<u32, BlockModes>> blocks(block_modes.begin(), block_modes.end());
+        auto useless = [](const BlockModes &m)
+        { return m.updates_received - m.useful_updates; };
+        auto order = [&](const auto &a, const auto &b)
+        {
+            return useless(a.second) != useless(b.second) ? useless(a.second) > useless(b.second) : a.first < b.first;
+        };
+        const size_t n = std::min<size_t>(blocks.size(), HYBRID_REPORT_BLOCKS);
+        std::partial_sort(blocks.begin(), blocks.begin() + n, blocks.end(), order);
+        blocks.resize(n);
+        return blocks;
+    }
+
+    // total returns the sum of a per-core metric.
+    u64 total(u64 CoreStats::*metric) const
     {
-        static Stats s;
-        return s;
+        u64 sum = 0;
+        for (const auto &c : st)
+            sum += c.*metric;
+        return sum;
     }
 
+    // Returns num / den, or 0 without a denominator.
+    static double ratio(u64 num, u64 den) { return den ? static_cast<double>(num) / den : 0.0; }
+
 public:
     Stats(const Stats &) = delete;
     Stats &operator=(const Stats &) = delete;
 
     // ────────────────────────────────
     // Initialization
-    static void initialize(int cache_size_, int assoc_, int block_size_, const std::string &protocol_name_)
-    {
-        auto &s = instance();
-        s.cache_size = cache_size_;
-        s.association = assoc_;
-        s.block_size = block_size_;
-        s.protocol_name = protocol_name_;
-        s.st.assign(NUM_OF_CORES, CoreStats{});
-    }
+    Stats(int cache_size, int assoc, int block_size, int num_cores, const std::string &protocol_name,
+          const std::string &replacement_name, int bus_slots = 0, bool snoop_filter = false, bool migratory = false)
+        : st(num_cores), block_size(block_size), cache_size(cache_size), association(assoc), bus_slots(bus_slots),
+          snoop_filter(snoop_filter), migratory(migratory),
+          protocol_name(protocol_name), replacement_name(replacement_name) {}
 
     // ────────────────────────────────
     // Core statistics
-    static void set_exec_cycles(int core, u64 cycles_to_set)
+    int num_cores() const { return static_cast<int>(st.size()); }
+
+    void set_exec_cycles(int core, u64 cycles_to_set)
     {
-        instance().st[core].exec_cycles = cycles_to_set;
-        instance().overall_exec = std::max(instance().overall_exec, cycles_to_set);
+        st[core].exec_cycles = cycles_to_set;
+        overall_exec = std::max(overall_exec, cycles_to_set);
     }
-    static u64 get_exec_cycles(int core) { return instance().st[core].exec_cycles; }
+    u64 get_exec_cycles(int core) const { return st[core].exec_cycles; }
 
-    static void add_exec_cycles(int core, u64 cycles_to_add) { set_exec_cycles(core, get_exec_cycles(core) + cycles_to_add); }
-    static void add_compute_cycles(int core, u64 cycles_to_add)
+    void add_exec_cycles(int core, u64 cycles_to_add) { set_exec_cycles(core, get_exec_cycles(core) + cycles_to_add); }
+    void add_compute_cycles(int core, u64 cycles_to_add)
     {
-        instance().st[core].compute_cycles += cycles_to_add;
-        instance().add_exec_cycles(core, cycles_to_add);
+        st[core].compute_cycles += cycles_to_add;
+        add_exec_cycles(core, cycles_to_add);
     }
-    static void add_idle_cycles(int core, u64 cycles_to_add)
+    void add_idle_cycles(int core, u64 cycles_to_add)
     {
-        instance().st[core].idle_cycles += cycles_to_add;
-        instance().add_exec_cycles(core, cycles_to_add);
+        st[core].idle_cycles += cycles_to_add;
+        add_exec_cycles(core, cycles_to_add);
     }
 
-    static void incr_load(int core) { instance().st[core].loads++; }
-    static void incr_store(int core) { instance().st[core].stores++; }
-    static void incr_hit(int core) { instance().st[core].hits++; }
-    static void incr_miss(int core) { instance().st[core].misses++; }
+    void incr_load(int core) { st[core].loads++; }
+    void incr_store(int core) { st[core].stores++; }
+    void incr_hit(int core) { st[core].hits++; }
+    void incr_miss(int core) { st[core].misses++; }
 
-    static void incr_private_access(int core) { instance().st[core].private_accesses++; }
-    static void incr_shared_access(int core) { instance().st[core].shared_accesses++; }
+    void incr_private_access(int core) { st[core].private_accesses++; }
+    void incr_shared_access(int core) { st[core].shared_accesses++; }
 
     // ────────────────────────────────
     // Bus statistics
-    static void add_bus_traffic_bytes(u64 bytes) { instance().overall_bus_total_data_bytes += bytes; }
-    static void incr_bus_invalidations() { instance().overall_bus_invalidations++; }
-    static void incr_bus_updates() { instance().overall_bus_updates++; }
+    void add_bus_traffic_bytes(u64 bytes) { overall_bus_total_data_bytes += bytes; }
+    void incr_bus_invalidations() { overall_bus_invalidations++; }
+    void incr_bus_updates() { overall_bus_updates++; }
+
+    // add_level registers a cache level below the L1s (top to bottom), and returns its index.
+    int add_level(const std::string &name, int banks, const std::string &inclusion)
+    {
+        levels.push_back({});
+        levels.back().name = name;
+        levels.back().bank_accesses.assign(banks, 0);
+        inclusion_name = inclusion;
+        return static_cast<int>(levels.size()) - 1;
+    }
+    LevelStats &level(int i) { return levels[i]; }
+
+    void incr_migratory_detections() { migratory_detections++; }
+    void incr_migratory_reads() { migratory_reads++; }
+    void incr_migratory_mispredictions() { migratory_mispredictions++; }
+    void incr_migratory_saved() { migratory_saved++; }
+
+    // migratory_net_saved returns the upgrades saved, less the exclusive reads never written
+    // (their BusRdX invalidated a copy that an ordinary read would have kept).
+    long long migratory_net_saved() const { return static_cast<long long>(migratory_saved) - static_cast<long long>(migratory_reads - migratory_saved); }
+
+    void incr_memory_fetches() { memory_fetches++; }
+    void incr_shared_memory_fetches() { shared_memory_fetches++; }
+    void incr_forwarded_reads() { forwarded_reads++; }
+
+    // Hybrid protocol: block is the block address.
+    void record_hybrid_write(u32 block, bool update_mode)
+    {
+        auto &m = block_modes[block];
+        (update_mode ? m.update_writes : m.local_writes)++;
+    }
+    void record_update_received(u32 block) { block_modes[block].updates_received++; }
+    void record_useful_update(u32 block) { block_modes[block].useful_updates++; }
+    void incr_self_invalidations() { self_invalidations++; }
+
+    // record_bus_transaction accounts one split-transaction bus transaction.
+    void record_bus_transaction(u64 request_queue_cycles, u64 response_queue_cycles, u64 data_cycles)
+    {
+        bus_transactions++;
+        bus_request_queue_cycles += request_queue_cycles;
+        bus_response_queue_cycles += response_queue_cycles;
+        bus_max_queue_cycles = std::max(bus_max_queue_cycles, request_queue_cycles + response_queue_cycles);
+        bus_data_cycles += data_cycles;
+    }
+
+    // record_snoops accounts one broadcast routed by the snoop filter to sent of the
+    // other_cores caches.
+    void record_snoops(u64 sent, u64 other_cores)
+    {
+        snoop_broadcasts++;
+        snoops_sent += sent;
+        snoops_filtered += other_cores - sent;
+    }
+    void record_snoop_filter_blocks(u64 blocks) { snoop_filter_blocks = std::max(snoop_filter_blocks, blocks); }
+    void set_snoop_filter_capacity(u64 entries) { snoop_filter_capacity = entries; }
+    void incr_snoop_filter_evictions() { snoop_filter_evictions++; }
+    void incr_snoop_filter_back_invalidations() { snoop_filter_back_invalidations++; }
+
+    // record_directory_request accounts one request to a home node, and the messages it caused:
+    // the request, the forwards, invalidations and acks, and one reply (with data_bytes of payload).
+    void record_directory_request(bool indirect, u64 forwards, u64 invalidations, u64 acks, u64 data_bytes)
+    {
+        const u64 messages = 2 + forwards + invalidations + acks;
+        dir_requests++;
+        dir_indirections += indirect;
+        dir_forwards += forwards;
+        dir_invalidations += invalidations;
+        dir_acks += acks;
+        dir_messages += messages;
+        dir_network_bytes += messages * MSG_HEADER_BYTES + data_bytes;
+    }
 
     // ────────────────────────────────
     // Output
-    static void print_results(bool json)
+
+    // CSV columns of print_csv_row, the per-core metrics are averaged over the cores.
+    static std::string csv_header()
+    {
+        return "Cache Size,Associativity,Block Size,Overall Execution Cycles,Bus Data Traffic Bytes,Bus Invalidations,Bus Updates,"
+               "Execution Cycles,Compute Cycles,Loads,Stores,Idle Cycles,Hits,Misses,Private Accesses,Shared Accesses,Replacement";
+    }
+
+    void print_csv_row(std::ostream &out) const
     {
-        auto &s = instance();
+        auto avg = [this](u64 CoreStats::*metric)
+        {
+            double sum = 0;
+            for (const auto &c : st)
+                sum += static_cast<double>(c.*metric);
+            return std::llround(sum / st.size());
+        };
+
+        out << cache_size << "," << association << "," << block_size << ","
+            << overall_exec << "," << overall_bus_total_data_bytes << ","
+            << overall_bus_invalidations << "," << overall_bus_updates << ","
+            << avg(&CoreStats::exec_cycles) << "," << avg(&CoreStats::compute_cycles) << ","
+            << avg(&CoreStats::loads) << "," << avg(&CoreStats::stores) << ","
+            << avg(&CoreStats::idle_cycles) << "," << avg(&CoreStats::hits) << ","
+            << avg(&CoreStats::misses) << "," << avg(&CoreStats::private_accesses) << ","
+            << avg(&CoreStats::shared_accesses) << "," << replacement_name << "\n";
+    }
+
+    void print_results(bool json, std::ostream &out = std::cout) const
+    {
+        // The number formatting set below is undone before returning, so it does not leak into the caller's stream.
+        const std::ios::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+        auto restore_format = [&]()
+        {
+            out.flags(flags);
+            out.precision(precision);
+        };
+
         if (json)
         {
-            std::cout << std::fixed << std::setprecision(2);
-            std::cout << "{\n";
-            std::cout << "  \"overall_execution_cycles\": " << s.overall_exec << ",\n";
-
-            s.print_array_json("per_core_execution_cycles", s.collect_metric([](const CoreStats &c)
-                                                                             { return c.exec_cycles; }));
-            s.print_array_json("per_core_compute_cycles", s.collect_metric([](const CoreStats &c)
-                                                                           { return c.compute_cycles; }));
-            s.print_array_json("per_core_loads", s.collect_metric([](const CoreStats &c)
-                                                                  { return c.loads; }));
-            s.print_array_json("per_core_stores", s.collect_metric([](const CoreStats &c)
-                                                                   { return c.stores; }));
-            s.print_array_json("per_core_idle_cycles", s.collect_metric([](const CoreStats &c)
-                                                                        { return c.idle_cycles; }));
-            s.print_array_json("per_core_hits", s.collect_metric([](const CoreStats &c)
-                                                                 { return c.hits; }));
-            s.print_array_json("per_core_misses", s.collect_metric([](const CoreStats &c)
-                                                                   { return c.misses; }));
-            s.print_array_json("per_core_private_accesses", s.collect_metric([](const CoreStats &c)
-                                                                             { return c.private_accesses; }));
-            s.print_array_json("per_core_shared_accesses", s.collect_metric([](const CoreStats &c)
-                                                                            { return c.shared_accesses; }));
-
-            std::cout << "  \"bus_data_traffic_bytes\": " << s.overall_bus_total_data_bytes << ",\n";
-            std::cout << "  \"bus_invalidations\": " << s.overall_bus_invalidations << ",\n";
-            std::cout << "  \"bus_updates\": " << s.overall_bus_updates << ",\n";
-            std::cout << "  \"protocol\": \"" << s.protocol_name << "\",\n";
-            std::cout << "  \"config\": {\"cache_size\": " << s.cache_size
-                      << ", \"associativity\": " << s.association
-                      << ", \"block_size\": " << s.block_size << "}\n";
-            std::cout << "}\n";
+            out << std::fixed << std::setprecision(2);
+            out << "{\n";
+            out << "  \"overall_execution_cycles\": " << overall_exec << ",\n";
+
+            print_array_json(out, "per_core_execution_cycles", collect_metric([](const CoreStats &c)
+                                                                                  { return c.exec_cycles; }));
+            print_array_json(out, "per_core_compute_cycles", collect_metric([](const CoreStats &c)
+                                                                                { return c.compute_cycles; }));
+            print_array_json(out, "per_core_loads", collect_metric([](const CoreStats &c)
+                                                                       { return c.loads; }));
+            print_array_json(out, "per_core_stores", collect_metric([](const CoreStats &c)
+                                                                        { return c.stores; }));
+            print_array_json(out, "per_core_idle_cycles", collect_metric([](const CoreStats &c)
+                                                                             { return c.idle_cycles; }));
+            print_array_json(out, "per_core_hits", collect_metric([](const CoreStats &c)
+                                                                      { return c.hits; }));
+            print_array_json(out, "per_core_misses", collect_metric([](const CoreStats &c)
+                                                                        { return c.misses; }));
+            print_array_json(out, "per_core_private_accesses", collect_metric([](const CoreStats &c)
+                                                                                  { return c.private_accesses; }));
+            print_array_json(out, "per_core_shared_accesses", collect_metric([](const CoreStats &c)
+                                                                                 { return c.shared_accesses; }));
+
+            out << "  \"bus_data_traffic_bytes\": " << overall_bus_total_data_bytes << ",\n";
+            out << "  \"bus_invalidations\": " << overall_bus_invalidations << ",\n";
+            out << "  \"bus_updates\": " << overall_bus_updates << ",\n";
+            out << "  \"memory_fetches\": " << memory_fetches << ",\n";
+            if (bus_slots > 0)
+            {
+                out << "  \"split_bus\": {\"slots\": " << bus_slots
+                    << ", \"transactions\": " << bus_transactions
+                    << ", \"avg_request_queue_cycles\": " << ratio(bus_request_queue_cycles, bus_transactions)
+                    << ", \"avg_response_queue_cycles\": " << ratio(bus_response_queue_cycles, bus_transactions)
+                    << ", \"max_queue_cycles\": " << bus_max_queue_cycles
+                    << std::setprecision(4)
+                    << ", \"address_utilization\": " << ratio(bus_transactions, overall_exec)
+                    << ", \"data_utilization\": " << ratio(bus_data_cycles, overall_exec) << "},\n"
+                    << std::setprecision(2);
+            }
+            if (!levels.empty())
+            {
+                const u64 l1_accesses = total(&CoreStats::loads) + total(&CoreStats::stores);
+                const u64 l1_misses = total(&CoreStats::misses);
+                out << "  \"hierarchy\": {\"inclusion\": \"" << inclusion_name << "\", \"levels\": [\n";
+                out << "    {\"level\": \"L1\", \"accesses\": " << l1_accesses << ", \"hits\": " << total(&CoreStats::hits)
+                    << ", \"misses\": " << l1_misses << std::setprecision(4) << ", \"miss_rate\": " << ratio(l1_misses, l1_accesses) << "}";
+                for (const auto &l : levels)
+                {
+                    out << ",\n    {\"level\": \"" << l.name << "\", \"accesses\": " << l.accesses << ", \"hits\": " << l.hits
+                        << ", \"misses\": " << l.misses << ", \"miss_rate\": " << ratio(l.misses, l.accesses)
+                        << ", \"global_miss_rate\": " << ratio(l.misses, l1_accesses)
+                        << ", \"avg_latency\": " << ratio(l.latency_cycles, l.accesses)
+                        << ", \"back_invalidations\": " << l.back_invalidations << ", \"writebacks\": " << l.writebacks
+                        << ", \"coherence_invalidations\": " << l.coherence_invalidations << ", \"remote_flushes\": " << l.remote_flushes;
+                    if (l.bank_accesses.size() > 1)
+                    {
+                        out << ", \"bank_accesses\": [";
+                        for (size_t b = 0; b < l.bank_accesses.size(); b++)
+                            out << (b == 0 ? "" : ",") << l.bank_accesses[b];
+                        out << "]";
+                    }
+                    out << "}";
+                }
+                out << "\n  ]},\n"
+                    << std::setprecision(2);
+            }
+            if (migratory)
+            {
+                out << "  \"migratory\": {\"detected\": " << migratory_detections
+                    << ", \"exclusive_reads\": " << migratory_reads
+                    << ", \"mispredicted\": " << migratory_mispredictions
+                    << ", \"saved_upgrades\": " << migratory_saved
+                    << ", \"saved_transactions\": " << migratory_net_saved() << "},\n";
+            }
+            if (protocol_name == "MESIF")
+            {
+                out << "  \"mesif\": {\"shared_memory_fetches\": " << shared_memory_fetches
+                    << ", \"forwarded_reads\": " << forwarded_reads << "},\n";
+            }
+            if (protocol_name == "Hybrid")
+            {
+                const auto [total, update_blocks] = hybrid_totals();
+                out << "  \"hybrid\": {\"update_writes\": " << total.update_writes
+                    << ", \"local_writes\": " << total.local_writes
+                    << ", \"updates_received\": " << total.updates_received
+                    << ", \"useless_updates\": " << total.updates_received - total.useful_updates
+                    << ", \"self_invalidations\": " << self_invalidations
+                    << ", \"update_write_blocks\": " << update_blocks
+                    << ", \"local_write_blocks\": " << block_modes.size() - update_blocks
+                    << ", \"most_wasted\": [";
+                const auto wasted = most_wasted_blocks();
+                for (size_t i = 0; i < wasted.size(); i++)
+                {
+                    const auto &[block, m] = wasted[i];
+                    out << (i == 0 ? "" : ", ") << "{\"block\": " << block
+                        << ", \"update_writes\": " << m.update_writes
+                        << ", \"local_writes\": " << m.local_writes
+                        << ", \"useless_updates\": " << m.updates_received - m.useful_updates << "}";
+                }
+                out << "]},\n";
+            }
+            if (protocol_name == "Directory")
+            {
+                out << "  \"directory\": {\"requests\": " << dir_requests
+                    << ", \"indirections\": " << dir_indirections
+                    << ", \"forwards\": " << dir_forwards
+                    << ", \"invalidations\": " << dir_invalidations
+                    << ", \"acks\": " << dir_acks
+                    << ", \"messages\": " << dir_messages
+                    << ", \"network_bytes\": " << dir_network_bytes << "},\n";
+            }
+            if (snoop_filter)
+            {
+                out << "  \"snoop_filter\": {\"ideal\": " << (snoop_filter_capacity == 0 ? "true" : "false")
+                    << ", \"capacity\": " << snoop_filter_capacity
+                    << ", \"lookups\": " << snoop_broadcasts
+                    << ", \"snoops_sent\": " << snoops_sent
+                    << ", \"snoops_filtered\": " << snoops_filtered
+                    << ", \"max_tracked_blocks\": " << snoop_filter_blocks
+                    << ", \"evictions\": " << snoop_filter_evictions
+                    << ", \"back_invalidations\": " << snoop_filter_back_invalidations << "},\n";
+            }
+            out << "  \"protocol\": \"" << protocol_name << "\",\n";
+            out << "  \"config\": {\"cache_size\": " << cache_size
+                << ", \"associativity\": " << association
+                << ", \"block_size\": " << block_size
+                << ", \"replacement\": \"" << replacement_name << "\"}\n";
+            out << "}\n";
         }
         else
         {
-            std::cout << "\n=== Simulation Results (" << s.protocol_name << " Protocol) ===\n";
-            std::cout << "Overall Execution Cycles: " << s.overall_exec << "\n";
-            std::cout << "Bus Data Traffic (bytes): " << s.overall_bus_total_data_bytes << "\n";
-            std::cout << "Bus Invalidations: " << s.overall_bus_invalidations << "\n";
-            std::cout << "Bus Updates: " << s.overall_bus_updates << "\n\n";
-
-            std::cout << std::left
-                      << std::setw(6) << "Core"
-                      << std::setw(14) << "Exec"
-                      << std::setw(14) << "Compute"
-                      << std::setw(12) << "Idle"
-                      << std::setw(10) << "Loads"
-                      << std::setw(10) << "Stores"
-                      << std::setw(10) << "Hits"
-                      << std::setw(10) << "Misses"
-                      << std::setw(14) << "Private"
-                      << std::setw(14) << "Shared"
-                      << "\n";
-
-            std::cout << std::string(110, '-') << "\n";
-
-            for (int i = 0; i < static_cast<int>(s.st.size()); ++i)
+            out << "\n=== Simulation Results (" << protocol_name << " Protocol) ===\n";
+            out << "Overall Execution Cycles: " << overall_exec << "\n";
+            out << "Bus Data Traffic (bytes): " << overall_bus_total_data_bytes << "\n";
+            out << "Bus Invalidations: " << overall_bus_invalidations << "\n";
+            out << "Bus Updates: " << overall_bus_updates << "\n";
+            out << "Memory Fetches: " << memory_fetches << "\n";
+            if (bus_slots > 0)
+            {
+                out << "Split Bus Slots: " << bus_slots << "\n";
+                out << "Split Bus Transactions: " << bus_transactions << "\n";
+                out << "Avg Request Queue Delay (cycles): " << std::fixed << std::setprecision(2)
+                    << ratio(bus_request_queue_cycles, bus_transactions) << "\n";
+                out << "Avg Response Queue Delay (cycles): " << ratio(bus_response_queue_cycles, bus_transactions) << "\n";
+                out << "Max Queue Delay (cycles): " << bus_max_queue_cycles << "\n";
+                out << "Address Bus Utilization: " << 100.0 * ratio(bus_transactions, overall_exec) << "%\n";
+                out << "Data Bus Utilization: " << 100.0 * ratio(bus_data_cycles, overall_exec) << "%\n";
+                restore_format();
+            }
+            if (!levels.empty())
+            {
+                const u64 l1_accesses = total(&CoreStats::loads) + total(&CoreStats::stores);
+                out << "Cache Hierarchy (" << inclusion_name << "):\n" << std::fixed << std::setprecision(2);
+                out << "  L1: " << l1_accesses << " accesses, " << total(&CoreStats::misses) << " misses ("
+                    << 100.0 * ratio(total(&CoreStats::misses), l1_accesses) << "%)\n";
+                for (const auto &l : levels)
+                {
+                    out << "  " << l.name << ": " << l.accesses << " accesses, " << l.misses << " misses ("
+                        << 100.0 * ratio(l.misses, l.accesses) << "%, " << 100.0 * ratio(l.misses, l1_accesses) << "% of L1 accesses), "
+                        << ratio(l.latency_cycles, l.accesses) << " avg latency, "
+                        << l.back_invalidations << " back-invalidations, " << l.writebacks << " writebacks, "
+                        << l.coherence_invalidations << " coherence invalidations, " << l.remote_flushes << " remote flushes\n";
+                    if (l.bank_accesses.size() > 1)
+                    {
+                        out << "  " << l.name << " Bank Accesses:";
+                        for (u64 a : l.bank_accesses)
+                            out << " " << a;
+                        out << "\n";
+                    }
+                }
+                restore_format();
+            }
+            if (migratory)
+            {
+                out << "Migratory Blocks Detected: " << migratory_detections << "\n";
+                out << "Migratory Exclusive Reads: " << migratory_reads << "\n";
+                out << "Migratory Mispredictions: " << migratory_mispredictions << "\n";
+                out << "Migratory Saved Upgrades: " << migratory_saved << "\n";
+                out << "Migratory Saved Transactions (net): " << migratory_net_saved() << "\n";
+            }
+            if (protocol_name == "MESIF")
+            {
+                out << "Memory Fetches (Shared, No Forwarder): " << shared_memory_fetches << "\n";
+                out << "Forwarded Clean Reads: " << forwarded_reads << "\n";
+            }
+            if (protocol_name == "Hybrid")
+            {
+                const auto [total, update_blocks] = hybrid_totals();
+                out << "Update/Local Writes: " << total.update_writes << "/" << total.local_writes << "\n";
+                out << "Updates Received: " << total.updates_received << "\n";
+                out << "Useless Updates: " << total.updates_received - total.useful_updates << "\n";
+                out << "Self Invalidations: " << self_invalidations << "\n";
+                out << "Blocks Mostly Written by Update/Locally: " << update_blocks << "/" << block_modes.size() - update_blocks << "\n";
+                out << "Most Wasted Update Blocks (block: update/local writes, useless updates):\n";
+                for (const auto &[block, m] : most_wasted_blocks())
+                {
+                    out << "  0x" << std::hex << block << std::dec << ": " << m.update_writes << "/" << m.local_writes
+                        << ", " << m.updates_received - m.useful_updates << "\n";
+                }
+            }
+            if (protocol_name == "Directory")
+            {
+                out << "Directory Requests: " << dir_requests << "\n";
+                out << "Directory Indirections: " << dir_indirections << "\n";
+                out << "Directory Forwards/Invalidations/Acks: " << dir_forwards << "/" << dir_invalidations << "/" << dir_acks << "\n";
+                out << "Network Messages: " << dir_messages << "\n";
+                out << "Network Bytes: " << dir_network_bytes << "\n";
+            }
+            if (snoop_filter)
+            {
+                if (snoop_filter_capacity == 0)
+                    out << "Snoop Filter: ideal (unbounded, never back-invalidates)\n";
+                else
+                    out << "Snoop Filter: " << snoop_filter_capacity << " entries, " << SNOOP_FILTER_WAYS << "-way\n";
+                out << "Snoop Filter Lookups: " << snoop_broadcasts << "\n";
+                out << "Snoops Sent: " << snoops_sent << "\n";
+                out << "Snoops Filtered: " << snoops_filtered << "\n";
+                out << "Max Tracked Blocks: " << snoop_filter_blocks << "\n";
+                out << "Snoop Filter Evictions: " << snoop_filter_evictions << "\n";
+                out << "Snoop Filter Back-Invalidations: " << snoop_filter_back_invalidations << "\n";
+            }
+            out << "\n";
+
+            out << std::left
+                << std::setw(6) << "Core"
+                << std::setw(14) << "Exec"
+                << std::setw(14) << "Compute"
+                << std::setw(12) << "Idle"
+                << std::setw(10) << "Loads"
+                << std::setw(10) << "Stores"
+                << std::setw(10) << "Hits"
+                << std::setw(10) << "Misses"
+                << std::setw(14) << "Private"
+                << std::setw(14) << "Shared"
+                << "\n";
+
+            out << std::string(110, '-') << "\n";
+
+            for (int i = 0; i < static_cast<int>(st.size()); ++i)
             {
-                const auto &c = s.st[i];
-                std::cout << std::left
-                          << std::setw(6) << i
-                          << std::setw(14) << c.exec_cycles
-                          << std::setw(14) << c.compute_cycles
-                          << std::setw(12) << c.idle_cycles
-                          << std::setw(10) << c.loads
-                          << std::setw(10) << c.stores
-                          << std::setw(10) << c.hits
-                          << std::setw(10) << c.misses
-                          << std::setw(14) << c.private_accesses
-                          << std::setw(14) << c.shared_accesses
-                          << "\n";
+                const auto &c = st[i];
+                out << std::left
+                    << std::setw(6) << i
+                    << std::setw(14) << c.exec_cycles
+                    << std::setw(14) << c.compute_cycles
+                    << std::setw(12) << c.idle_cycles
+                    << std::setw(10) << c.loads
+                    << std::setw(10) << c.stores
+                    << std::setw(10) << c.hits
+                    << std::setw(10) << c.misses
+                    << std::setw(14) << c.private_accesses
+                    << std::setw(14) << c.shared_accesses
+                    << "\n";
             }
-            std::cout << "\n";
+            out << "\n";
         }
+        restore_format();
     }
 };
@@ -1,10 +1,18 @@
 #pragma once
 #include <string>
-#include <fstream>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <memory>
 #include <iostream>
 #include <charconv>
+#include <algorithm>
 #include "types.hpp"
 #include "utils.hpp"
+#include "mapped_file.hpp"
+#include "zip_archive.hpp"
+#include "simd_parse.hpp"
 
 // Operation defines the possible operations the input can take.
 enum class Operation
@@ -37,61 +45,186 @@ static Operation parse_operation_sv(std::string_view label)
         std::exit(2);
     }
 }
-// Each TraceItem represents a single line from the input.
+// Compute cycles folded into a TraceItem use the low TRACE_GAP_BITS bits of the record.
+static constexpr u32 TRACE_GAP_BITS = 30;
+static constexpr u64 TRACE_GAP_MAX = (1ULL << TRACE_GAP_BITS) - 1;
+
+// Each TraceItem represents a memory operation (load or store) from the input,
+// with the compute cycles (label 2 lines) that precede it folded into its gap.
+// Operation::Other items are compute-only: they carry compute cycles that do not
+// fit in the next item's gap, or that trail the last memory operation.
 struct TraceItem
 {
-    Operation op;
-
-    // cycles is present only if the operation is a non mem op (other).
-    u64 cycles = 0;
-
     // addr is present only if the operation is a mem op (store or load).
     u32 addr = 0;
+
+    // Operation in the top 2 bits, compute gap in cycles in the low TRACE_GAP_BITS bits.
+    u32 op_gap = 0;
+
+    TraceItem() = default;
+    TraceItem(Operation op, u32 addr, u64 gap)
+        : addr(addr), op_gap((static_cast<u32>(op) << TRACE_GAP_BITS) | static_cast<u32>(gap)) {}
+
+    Operation op() const { return static_cast<Operation>(op_gap >> TRACE_GAP_BITS); }
+    u64 gap() const { return op_gap & TRACE_GAP_MAX; }
 };
+static_assert(sizeof(TraceItem) == 8, "TraceItem is packed in 8 bytes");
 
-// Simple, line-by-line trace parser (no regex). We coalesce compute (label 2) into gap_before_op.
-static std::vector<TraceItem> parse_trace(const std::string &path)
+// TraceFolder folds the records of a trace (one per line) into TraceItems,
+// by accumulating the compute cycles until the next memory operation.
+struct TraceFolder
 {
-    std::ifstream in(path);
-    if (!in)
+    u64 pending = 0; // Compute cycles not yet attached to a memory operation.
+
+    void add(std::vector<TraceItem> &out, Operation op, u32 value)
     {
-        std::cerr << "Cannot open: " << path << "\n";
-        std::exit(2);
+        if (op == Operation::Other)
+        {
+            pending += value;
+            return;
+        }
+        while (pending > TRACE_GAP_MAX)
+        {
+            out.emplace_back(Operation::Other, 0, TRACE_GAP_MAX);
+            pending -= TRACE_GAP_MAX;
+        }
+        out.emplace_back(op, value, pending);
+        pending = 0;
     }
 
-    std::vector<TraceItem> out;
-    out.reserve(1'000'000); // optional
+    // flush emits the pending compute cycles as compute-only items (at the end of a trace).
+    void flush(std::vector<TraceItem> &out)
+    {
+        while (pending > 0)
+        {
+            u64 gap = std::min(pending, TRACE_GAP_MAX);
+            out.emplace_back(Operation::Other, 0, gap);
+            pending -= gap;
+        }
+    }
+};
+
+// Approximate bytes of trace file per TraceItem (e.g. "0 0x817ae8\n2 0x1b\n" is one item).
+// Used to size the output from the file length without a counting pass.
+static constexpr size_t TRACE_BYTES_PER_RECORD = 12;
 
-    std::string line;
-    while (std::getline(in, line))
+// parse_trace_bytes_scalar parses the trace records in [begin, end) in place,
+// until out holds out_limit items. Items are appended to out through folder;
+// path is only used for error messages.
+// Returns where parsing stopped (end once every record has been parsed).
+static const char *parse_trace_bytes_scalar(const char *begin, const char *end, const std::string &path,
+                                            std::vector<TraceItem> &out, TraceFolder &folder, size_t out_limit = SIZE_MAX)
+{
+    const char *p = begin;
+    while (p < end && out.size() < out_limit)
     {
+        const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (eol == nullptr)
+            eol = end;
+
         // trim trailing spaces and carriage return
-        line.erase(line.find_last_not_of(" \r\n") + 1);
-        if (line.empty())
+        const char *last = eol;
+        while (last > p && (last[-1] == ' ' || last[-1] == '\r'))
+            last--;
+
+        if (last == p)
+        {
+            p = eol < end ? eol + 1 : end;
             continue;
+        }
 
-        auto pos = line.find_first_of(" \t");
-        if (pos == std::string::npos)
+        const char *sep = p;
+        while (sep < last && *sep != ' ' && *sep != '\t')
+            sep++;
+        if (sep == last)
         {
-            std::cerr << "Bad line in " << path << ": '" << line << "'\n";
+            std::cerr << "Bad line in " << path << ": '" << std::string_view(p, last - p) << "'\n";
             std::exit(2);
         }
 
-        std::string_view label(line.data(), pos);
-        std::string_view value(line.data() + pos + 1, line.size() - pos - 1);
+        std::string_view label(p, sep - p);
+        std::string_view value(sep + 1, last - sep - 1);
 
         Operation op = parse_operation_sv(label);
-
-        TraceItem it;
-        it.op = op;
         u32 parsed_val = parse_auto_base_sv(value);
-        if (op == Operation::Other)
-            it.cycles = parsed_val;
-        else
-            it.addr = parsed_val;
+        folder.add(out, op, parsed_val);
+
+        p = eol < end ? eol + 1 : end;
+    }
+
+    return p;
+}
+
+// parse_trace_bytes is the vectorized equivalent of parse_trace_bytes_scalar.
+// Newlines are located a 64-byte block at a time and every canonical record in
+// the block is converted without branching per digit; any other line (blank,
+// CR, decimal, malformed) goes through the scalar parser, which also reports errors.
+static const char *parse_trace_bytes(const char *begin, const char *end, const std::string &path,
+                                     std::vector<TraceItem> &out, TraceFolder &folder, size_t out_limit = SIZE_MAX)
+{
+    const char *p = begin;
+    if (SIMD_PARSE_ENABLED)
+    {
+        while (out.size() < out_limit && static_cast<size_t>(end - p) >= SIMD_BLOCK_BYTES + SIMD_SLACK_BYTES)
+        {
+            u64 newlines = newline_mask64(p);
+            if (newlines == 0)
+                break; // A line longer than a block, leave it to the scalar parser.
+            u64 hex_digits = hex_digit_mask64(p);
 
-        out.push_back(it);
+            const char *line = p;
+            while (newlines != 0 && out.size() < out_limit)
+            {
+                const char *eol = p + __builtin_ctzll(newlines);
+                newlines &= newlines - 1;
+
+                int label = 0;
+                u32 value = 0;
+                if (parse_record_fast(line, eol - line, hex_digits >> (line - p), label, value))
+                    folder.add(out, static_cast<Operation>(label), value);
+                else
+                    parse_trace_bytes_scalar(line, eol + 1, path, out, folder);
+                line = eol + 1;
+            }
+            p = line;
+        }
+    }
+
+    return parse_trace_bytes_scalar(p, end, path, out, folder, out_limit);
+}
+
+// Zero-copy trace parser: the file is memory mapped and scanned in place,
+// without any per-line allocation.
+static std::vector<TraceItem> parse_trace(const std::string &path)
+{
+    MappedFile file(path);
+
+    std::vector<TraceItem> out;
+    out.reserve(file.size() / TRACE_BYTES_PER_RECORD + 1);
+    TraceFolder folder;
+    parse_trace_bytes(file.begin(), file.end(), path, out, folder);
+    folder.flush(out);
+
+    return out;
+}
+
+// parse_zip_trace parses a text trace member of a zip archive ("<archive>.zip:<member>"),
+// inflating it chunk by chunk straight into the parser.
+static std::vector<TraceItem> parse_zip_trace(const std::string &path)
+{
+    std::string archive, member;
+    split_zip_path(path, archive, member);
+    ZipLineStream stream(std::make_shared<const ZipArchive>(archive), member);
+
+    std::vector<TraceItem> out;
+    out.reserve(stream.size() / TRACE_BYTES_PER_RECORD + 1);
+    TraceFolder folder;
+    const char *begin = nullptr, *end = nullptr;
+    while (stream.next(begin, end))
+    {
+        parse_trace_bytes(begin, end, path, out, folder);
     }
+    folder.flush(out);
 
     return out;
 }
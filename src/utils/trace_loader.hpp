@@ -0,0 +1,161 @@
+// trace_loader.hpp contains the parallel loader for the per-core traces.
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include "types.hpp"
+#include "mapped_file.hpp"
+#include "trace_item.hpp"
+#include "binary_trace.hpp"
+#include "zip_archive.hpp"
+
+// -------------------
+// Parallel loading configuration
+// -------------------
+static constexpr size_t PARSE_SPLIT_BYTES = 4 << 20; // Text traces are split into parse tasks of at least this size.
+
+// parse_threads returns the number of threads used for loading traces.
+inline size_t parse_threads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// parallel_for runs fn(i) for every i in [0, n) on a small pool of threads.
+template <typename F>
+void parallel_for(size_t n, F fn)
+{
+    size_t num_threads = std::min(n, parse_threads());
+    if (num_threads <= 1)
+    {
+        for (size_t i = 0; i < n; i++)
+            fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]
+    {
+        for (size_t i = next++; i < n; i = next++)
+            fn(i);
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(num_threads - 1);
+    for (size_t t = 1; t < num_threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &th : pool)
+        th.join();
+}
+
+// append_folded appends the items of the next segment of a trace to dst. The compute
+// cycles trailing dst are folded into the first memory operation of src, exactly
+// as if both segments had been parsed in one pass.
+inline void append_folded(std::vector<TraceItem> &dst, const std::vector<TraceItem> &src)
+{
+    TraceFolder folder;
+    while (!dst.empty() && dst.back().op() == Operation::Other)
+    {
+        folder.pending += dst.back().gap();
+        dst.pop_back();
+    }
+
+    size_t i = 0;
+    for (; i < src.size() && src[i].op() == Operation::Other; i++)
+        folder.pending += src[i].gap();
+    if (i == src.size())
+    {
+        folder.flush(dst);
+        return;
+    }
+
+    folder.pending += src[i].gap();
+    folder.add(dst, src[i].op(), src[i].addr);
+    dst.insert(dst.end(), src.begin() + i + 1, src.end());
+}
+
+// load_traces_parallel loads every trace concurrently. Text trace files are
+// additionally split at line boundaries, so one large file is parsed by several
+// threads. The result is identical to calling load_trace on each path in turn.
+inline std::vector<std::vector<TraceItem>> load_traces_parallel(const std::vector<std::string> &paths)
+{
+    struct Task
+    {
+        size_t trace;
+        const char *begin = nullptr; // Byte range of a text trace segment,
+        const char *end = nullptr;   // or nullptr to load the whole trace.
+    };
+
+    std::vector<std::unique_ptr<MappedFile>> files(paths.size());
+    std::vector<Task> tasks;
+    for (size_t c = 0; c < paths.size(); c++)
+    {
+        std::string archive, member;
+        if (split_zip_path(paths[c], archive, member) || is_binary_trace_path(paths[c]))
+        {
+            // Zip members and binary traces can only be decoded front to back.
+            tasks.push_back({c});
+            continue;
+        }
+
+        files[c] = std::make_unique<MappedFile>(paths[c]);
+        const char *p = files[c]->begin();
+        const char *end = files[c]->end();
+        size_t segments = std::max<size_t>(1, std::min(files[c]->size() / PARSE_SPLIT_BYTES, parse_threads()));
+        size_t step = files[c]->size() / segments;
+        for (size_t s = 1; s <= segments && p < end; s++)
+        {
+            // Each segment ends just after a newline (or at the end of the file).
+            const char *seg_end = end;
+            if (s < segments && p + step < end)
+            {
+                const char *nl = static_cast<const char *>(std::memchr(p + step, '\n', end - (p + step)));
+                seg_end = nl != nullptr ? nl + 1 : end;
+            }
+            tasks.push_back({c, p, seg_end});
+            p = seg_end;
+        }
+    }
+
+    std::vector<std::vector<TraceItem>> parts(tasks.size());
+    parallel_for(tasks.size(), [&](size_t t)
+                 {
+                     const Task &task = tasks[t];
+                     if (task.begin == nullptr)
+                     {
+                         parts[t] = load_trace(paths[task.trace]);
+                         return;
+                     }
+                     parts[t].reserve((task.end - task.begin) / TRACE_BYTES_PER_RECORD + 1);
+                     TraceFolder folder;
+                     parse_trace_bytes(task.begin, task.end, paths[task.trace], parts[t], folder);
+                     folder.flush(parts[t]); });
+
+    // Stitch the segments of each trace back together in file order.
+    std::vector<size_t> totals(paths.size(), 0), counts(paths.size(), 0);
+    for (size_t t = 0; t < tasks.size(); t++)
+    {
+        totals[tasks[t].trace] += parts[t].size();
+        counts[tasks[t].trace]++;
+    }
+
+    std::vector<std::vector<TraceItem>> out(paths.size());
+    for (size_t t = 0; t < tasks.size(); t++)
+    {
+        size_t c = tasks[t].trace;
+        if (counts[c] == 1)
+        {
+            out[c] = std::move(parts[t]);
+            continue;
+        }
+        if (out[c].capacity() < totals[c])
+            out[c].reserve(totals[c]);
+        append_folded(out[c], parts[t]);
+        std::vector<TraceItem>().swap(parts[t]);
+    }
+    return out;
+}
@@ -0,0 +1,299 @@
+// trace_stream.hpp contains the per-core trace cursor used by the simulator,
+// which either walks a fully loaded trace or streams it from disk in chunks.
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <deque>
+#include <algorithm>
+#include "types.hpp"
+#include "mapped_file.hpp"
+#include "trace_item.hpp"
+#include "binary_trace.hpp"
+#include "zip_archive.hpp"
+
+// -------------------
+// Streaming configuration
+// -------------------
+static constexpr size_t STREAM_CHUNK_RECORDS = 1 << 16; // Trace items per streaming buffer (two buffers per core).
+
+// TraceReader incrementally decodes a text or binary trace file, or a text trace
+// inflated from a zip archive. Consumed pages of a trace file are dropped,
+// so its resident size is bounded by the chunk size.
+class TraceReader
+{
+private:
+    std::string path;
+    std::unique_ptr<MappedFile> file;
+    std::unique_ptr<ZipLineStream> zip;
+    bool binary = false;
+    const char *cur = nullptr;
+    const char *end = nullptr;
+
+    // Binary decoding state.
+    u64 remaining = 0;
+    u32 prev_addr = 0;
+
+    // Compute cycles carried over to the next chunk.
+    TraceFolder folder;
+
+public:
+    explicit TraceReader(const std::string &path) : path(path)
+    {
+        std::string archive, member;
+        if (split_zip_path(path, archive, member))
+        {
+            zip = std::make_unique<ZipLineStream>(std::make_shared<const ZipArchive>(archive), member);
+            return;
+        }
+
+        file = std::make_unique<MappedFile>(path);
+        binary = is_binary_trace_path(path);
+        cur = file->begin();
+        end = file->end();
+        if (binary)
+        {
+            const auto *p = reinterpret_cast<const unsigned char *>(cur);
+            remaining = read_binary_header(p, reinterpret_cast<const unsigned char *>(end), path);
+            cur = reinterpret_cast<const char *>(p);
+        }
+    }
+
+    // read replaces the contents of out with up to max_items items.
+    // Returns false once the trace is exhausted (out is then empty).
+    bool read(std::vector<TraceItem> &out, size_t max_items)
+    {
+        out.clear();
+        bool exhausted = false;
+        if (binary)
+        {
+            const auto *p = reinterpret_cast<const unsigned char *>(cur);
+            decode_binary_records(p, reinterpret_cast<const unsigned char *>(end), remaining, prev_addr, path, out, folder, max_items);
+            cur = reinterpret_cast<const char *>(p);
+            exhausted = remaining == 0;
+        }
+        else
+        {
+            while (out.size() < max_items)
+            {
+                // Zip members are inflated one window of whole lines at a time.
+                if (cur == end && (zip == nullptr || !zip->next(cur, end)))
+                {
+                    exhausted = true;
+                    break;
+                }
+                cur = parse_trace_bytes(cur, end, path, out, folder, max_items);
+            }
+        }
+        if (exhausted)
+            folder.flush(out);
+        if (file != nullptr)
+            file->release_before(cur);
+        return !out.empty();
+    }
+};
+
+// SharedTrace decodes one core's trace once for several simulations (see LockstepSim).
+// Chunks are decoded when the first reader reaches them, and freed once every
+// reader has moved past them.
+class SharedTrace
+{
+private:
+    struct Chunk
+    {
+        std::vector<TraceItem> items;
+        size_t readers; // Readers that have not finished the chunk yet.
+    };
+
+    TraceReader reader;
+    size_t num_readers;
+    bool exhausted = false;
+    std::deque<Chunk> chunks;
+    size_t first = 0; // Index of chunks.front() in the trace.
+
+public:
+    SharedTrace(const std::string &path, size_t num_readers) : reader(path), num_readers(num_readers) {}
+
+    // chunk returns the items of chunk i, or nullptr past the end of the trace.
+    const std::vector<TraceItem> *chunk(size_t i)
+    {
+        while (i >= first + chunks.size() && !exhausted)
+        {
+            Chunk next{{}, num_readers};
+            if (reader.read(next.items, STREAM_CHUNK_RECORDS))
+                chunks.push_back(std::move(next));
+            else
+                exhausted = true;
+        }
+        return i < first + chunks.size() ? &chunks[i - first].items : nullptr;
+    }
+
+    // done releases a reader's hold on chunk i.
+    void done(size_t i)
+    {
+        chunks[i - first].readers--;
+        while (!chunks.empty() && chunks.front().readers == 0)
+        {
+            chunks.pop_front();
+            first++;
+        }
+    }
+};
+
+// TraceStream is a forward cursor over the records of one core's trace.
+//
+// In streaming mode a background reader thread fills a double-buffered ring:
+// the simulator consumes the front buffer while the reader decodes the next chunk
+// into the back buffer, so memory stays constant and I/O overlaps simulation.
+class TraceStream
+{
+private:
+    // Records of the buffer being consumed.
+    std::vector<TraceItem> front;
+    const TraceItem *pos = nullptr;
+    const TraceItem *end = nullptr;
+
+    // Shared decoding state (when reading from a SharedTrace).
+    SharedTrace *shared = nullptr;
+    size_t shared_chunk = 0;
+
+    // Streaming state (unused when the whole trace is loaded).
+    std::unique_ptr<TraceReader> reader;
+    std::vector<TraceItem> back;
+    bool back_ready = false; // back holds a chunk that the consumer has not taken yet.
+    bool reader_done = false;
+    bool stopping = false;
+    std::mutex mu;
+    std::condition_variable cv;
+    std::thread io_thread;
+
+    void reader_loop()
+    {
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mu);
+                cv.wait(lock, [this]
+                        { return !back_ready || stopping; });
+                if (stopping)
+                    return;
+            }
+
+            // The back buffer is owned by the reader until back_ready is set.
+            bool more = reader->read(back, STREAM_CHUNK_RECORDS);
+
+            std::lock_guard<std::mutex> lock(mu);
+            if (more)
+                back_ready = true;
+            else
+                reader_done = true;
+            cv.notify_all();
+            if (!more)
+                return;
+        }
+    }
+
+    // next_shared_chunk moves to the next chunk of the shared trace.
+    bool next_shared_chunk()
+    {
+        shared->done(shared_chunk);
+        const std::vector<TraceItem> *items = shared->chunk(++shared_chunk);
+        if (items == nullptr)
+        {
+            shared = nullptr;
+            return false;
+        }
+        pos = items->data();
+        end = items->data() + items->size();
+        return true;
+    }
+
+    // refill swaps in the next chunk, returns false at the end of the trace.
+    bool refill()
+    {
+        if (shared != nullptr)
+            return next_shared_chunk();
+        if (!reader)
+            return false;
+
+        std::unique_lock<std::mutex> lock(mu);
+        cv.wait(lock, [this]
+                { return back_ready || reader_done; });
+        if (!back_ready)
+            return false;
+
+        front.swap(back);
+        back_ready = false;
+        cv.notify_all();
+        pos = front.data();
+        end = front.data() + front.size();
+        return true;
+    }
+
+public:
+    TraceStream() = default;
+    TraceStream(const TraceStream &) = delete;
+    TraceStream &operator=(const TraceStream &) = delete;
+
+    ~TraceStream()
+    {
+        if (io_thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mu);
+                stopping = true;
+            }
+            cv.notify_all();
+            io_thread.join();
+        }
+    }
+
+    // load takes a fully parsed trace.
+    void load(std::vector<TraceItem> items)
+    {
+        front = std::move(items);
+        pos = front.data();
+        end = front.data() + front.size();
+    }
+
+    // view walks a parsed trace owned by the caller, which must outlive the stream.
+    // Several simulations can share one trace this way.
+    void view(const std::vector<TraceItem> &items)
+    {
+        pos = items.data();
+        end = items.data() + items.size();
+    }
+
+    // share reads the trace from a SharedTrace, which must outlive the stream.
+    void share(SharedTrace &src)
+    {
+        const std::vector<TraceItem> *items = src.chunk(0);
+        if (items == nullptr)
+            return;
+        shared = &src;
+        pos = items->data();
+        end = items->data() + items->size();
+    }
+
+    // stream starts the background reader for the trace file at path.
+    void stream(const std::string &path)
+    {
+        reader = std::make_unique<TraceReader>(path);
+        front.reserve(STREAM_CHUNK_RECORDS);
+        back.reserve(STREAM_CHUNK_RECORDS);
+        io_thread = std::thread(&TraceStream::reader_loop, this);
+    }
+
+    // peek returns the current record, or nullptr at the end of the trace.
+    const TraceItem *peek()
+    {
+        if (pos == end && !refill())
+            return nullptr;
+        return pos;
+    }
+
+    void advance() { pos++; }
+};
@@ -3,14 +3,15 @@
 
 using u64 = unsigned long long;
 using u32 = uint32_t;
+using u16 = uint16_t;
+using u8 = uint8_t;
 
 struct CacheLine
 {
     int state = 0; // Generic protocol-defined state representation. (MESI/Dragon use different enums)
 
-    u64 lru = 0;
-    u32 tag = 0;
-    u32 addr;
+    u32 addr; // Tags and LRU stamps are kept in the tag store of the Cache.
     bool valid = false;
     bool dirty = false;
+    u16 counter = 0; // Generic protocol-defined counter (e.g. updates received since the last access).
 };
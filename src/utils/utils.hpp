@@ -9,6 +9,7 @@
 #include <charconv>
 #include "constants.hpp"
 #include "types.hpp"
+#include "zip_archive.hpp"
 
 // file_exists checks if a file with the path exists.
 inline bool file_exists(const std::string &path)
@@ -54,54 +55,158 @@ inline std::string resolve_part1_trace_path(const std::string &input)
     std::exit(2);
 }
 
-// resolve_four resolves NUM_OF_CORES input trace files.
-static std::vector<std::string> resolve_four(const std::string &input)
+// split_list splits a comma separated CLI argument ("MESI,MOESI" or "1,2,4"),
+// or one separated by sep ("65536:8:4").
+inline std::vector<std::string> split_list(const std::string &arg, char sep = ',')
 {
-    std::vector<std::string> v(NUM_OF_CORES);
-    // Case A: explicit _0.data
-    if (input.size() > 7 && input.rfind("_0.data") == input.size() - 7)
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (true)
     {
-        const auto base = input.substr(0, input.size() - 7);
-        for (int i = 0; i < NUM_OF_CORES; i++)
-        {
-            v[i] = base + "_" + std::to_string(i) + ".data";
-        }
-        for (auto &p : v)
+        size_t comma = arg.find(sep, start);
+        items.push_back(arg.substr(start, comma - start));
+        if (comma == std::string::npos)
+            return items;
+        start = comma + 1;
+    }
+}
+
+// Trace file extensions accepted by resolve_traces: text traces, then binary traces.
+static const std::vector<std::string> TRACE_EXTS = {".data", ".bin"};
+
+// count_traces returns the number of traces "<base>_0", "<base>_1", ... for which exists
+// returns true, stopping at the first missing one (or at num_cores, if set).
+template <typename Exists>
+int count_traces(const std::string &base, int num_cores, Exists exists)
+{
+    int n = 0;
+    while ((num_cores <= 0 || n < num_cores) && exists(base + "_" + std::to_string(n)))
+        n++;
+    return n;
+}
+
+// trace_paths returns the n trace paths "<prefix><base>_<i><ext>".
+inline std::vector<std::string> trace_paths(const std::string &prefix, const std::string &base, const std::string &ext, int n)
+{
+    std::vector<std::string> v(n);
+    for (int i = 0; i < n; i++)
+        v[i] = prefix + base + "_" + std::to_string(i) + ext;
+    return v;
+}
+
+// resolve_with_ext returns the trace paths "<base>_<i><ext>", one per core,
+// or an empty vector if there are none (or fewer than num_cores, if set).
+inline std::vector<std::string> resolve_with_ext(const std::string &base, const std::string &ext, int num_cores)
+{
+    int n = count_traces(base, num_cores, [&](const std::string &name)
+                         { return file_exists(name + ext); });
+    if (n == 0 || (num_cores > 0 && n < num_cores))
+        return {};
+    return trace_paths("", base, ext, n);
+}
+
+// resolve_zip resolves the trace members "<base>_<i>.data" of a zip archive, one per core,
+// as "<archive>.zip:<member>" paths. input is either "<archive>.zip", if the archive holds
+// a single set of traces, or "<archive>.zip:<base>".
+inline std::vector<std::string> resolve_zip(const std::string &input, int num_cores = 0)
+{
+    std::string archive_path = input, want;
+    split_zip_path(input, archive_path, want);
+    if (!file_exists(archive_path))
+    {
+        std::cerr << "Missing: " << archive_path << "\n";
+        std::exit(2);
+    }
+    ZipArchive archive(archive_path);
+
+    // Find the "_0.data" members, skipping macOS resource forks.
+    const std::string suffix = "_0" + TRACE_EXTS[0];
+    std::vector<std::string> bases;
+    for (const auto &entry : archive.list())
+    {
+        const auto &name = entry.name;
+        if (name.rfind("__MACOSX/", 0) == 0 || name.size() <= suffix.size() ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+            continue;
+        auto base = name.substr(0, name.size() - suffix.size());
+        auto slash = base.rfind('/');
+        if (want.empty() || base.substr(slash == std::string::npos ? 0 : slash + 1) == want)
+            bases.push_back(base);
+    }
+    if (bases.size() != 1)
+    {
+        std::cerr << "Could not resolve a single set of traces in " << input << ", use <archive>.zip:<base>. Found:";
+        for (const auto &b : bases)
+            std::cerr << " " << b;
+        std::cerr << "\n";
+        std::exit(2);
+    }
+
+    int n = count_traces(bases[0], num_cores, [&](const std::string &name)
+                         { return archive.find(name + TRACE_EXTS[0]) != nullptr; });
+    if (num_cores > 0 && n < num_cores)
+    {
+        std::cerr << "Missing: " << archive_path << ZIP_MEMBER_SEP << bases[0] << "_" << n << TRACE_EXTS[0] << "\n";
+        std::exit(2);
+    }
+    return trace_paths(archive_path + ZIP_MEMBER_SEP, bases[0], TRACE_EXTS[0], n);
+}
+
+// resolve_traces resolves the input trace files, one per core.
+// The core count is the number of consecutive traces "<base>_0", "<base>_1", ...
+// found, unless num_cores is set: then exactly the first num_cores traces are used.
+inline std::vector<std::string> resolve_traces(const std::string &input, int num_cores = 0)
+{
+    // Case A: zip archive, read in place (e.g., "tests/benchmark/bodytrack_four.zip")
+    std::string archive, member;
+    if (split_zip_path(input, archive, member) ||
+        (input.size() > ZIP_EXT.size() && input.compare(input.size() - ZIP_EXT.size(), ZIP_EXT.size(), ZIP_EXT) == 0))
+    {
+        return resolve_zip(input, num_cores);
+    }
+
+    // Case B: explicit _0.data (or _0.bin)
+    for (const auto &ext : TRACE_EXTS)
+    {
+        const std::string suffix = "_0" + ext;
+        if (input.size() > suffix.size() && input.rfind(suffix) == input.size() - suffix.size())
         {
-            if (!file_exists(p))
+            const auto base = input.substr(0, input.size() - suffix.size());
+            auto v = resolve_with_ext(base, ext, num_cores);
+            if (v.empty())
             {
-                std::cerr << "Missing: " << p << "\n";
+                int n = count_traces(base, num_cores, [&](const std::string &name)
+                                     { return file_exists(name + ext); });
+                std::cerr << "Missing: " << base << "_" << n << ext << "\n";
                 std::exit(2);
             }
+            return v;
         }
-        return v;
     }
 
-    // Case B: bare base (e.g., "bodytrack") — try DEFAULT_TRACES_PATH then CWD
-    std::vector<std::string> tries(NUM_OF_CORES);
-    bool ok = true;
-    for (int i = 0; i < NUM_OF_CORES; i++)
-    {
-        tries[i] = DEFAULT_TRACES_PATH + input + "_" + std::to_string(i) + ".data",
-        ok = ok && file_exists(tries[i]);
-    }
-    if (ok)
+    // Case C: bare base (e.g., "bodytrack") — try DEFAULT_TRACES_PATH then CWD
+    for (const auto &base : {DEFAULT_TRACES_PATH + input, input})
     {
-        return tries;
+        for (const auto &ext : TRACE_EXTS)
+        {
+            auto tries = resolve_with_ext(base, ext, num_cores);
+            if (!tries.empty())
+            {
+                return tries;
+            }
+        }
     }
 
-    ok = true;
-    for (int i = 0; i < NUM_OF_CORES; i++)
-    {
-        tries[i] = input + "_" + std::to_string(i) + ".data",
-        ok = ok && file_exists(tries[i]);
-    }
-    if (ok)
+    // Case D: not extracted yet — read the benchmark archive directly
+    for (const auto &zip : {DEFAULT_BENCHMARKS_PATH + input + "_four" + ZIP_EXT, DEFAULT_BENCHMARKS_PATH + input + ZIP_EXT})
     {
-        return tries;
+        if (file_exists(zip))
+        {
+            return resolve_zip(zip + ZIP_MEMBER_SEP + input, num_cores);
+        }
     }
 
-    std::cerr << "Could not resolve " << NUM_OF_CORES << " trace files for base '" << input << "'.\n";
+    std::cerr << "Could not resolve the trace files for base '" << input << "'.\n";
     std::cerr << "Provide e.g.: ./coherence MESI " << DEFAULT_TRACES_PATH << "bodytrack_0.data 4096 2 32\n";
     std::exit(2);
 }
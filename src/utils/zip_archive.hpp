@@ -0,0 +1,279 @@
+// zip_archive.hpp contains a minimal reader for the benchmark zip archives,
+// which inflates members in memory (no temporary files).
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <cstring>
+#include <zlib.h>
+#include "types.hpp"
+#include "mapped_file.hpp"
+
+// -------------------
+// Zip configuration
+// -------------------
+static constexpr size_t ZIP_INFLATE_CHUNK_BYTES = 1 << 20; // Inflated bytes handed to the parser at a time.
+static const std::string ZIP_EXT = ".zip";
+static constexpr char ZIP_MEMBER_SEP = ':'; // Trace paths into archives are written "<archive>.zip:<member>".
+
+struct ZipEntry
+{
+    std::string name;
+    int method = 0;       // 0 stored, 8 deflated.
+    u32 crc = 0;          // CRC-32 of the uncompressed data.
+    u64 comp_size = 0;    // Compressed size in bytes.
+    u64 size = 0;         // Uncompressed size in bytes.
+    u64 local_offset = 0; // Offset of the local file header.
+};
+
+// split_zip_path splits "<archive>.zip:<member>" into its parts.
+// Returns false if path does not name a zip member.
+inline bool split_zip_path(const std::string &path, std::string &archive, std::string &member)
+{
+    auto pos = path.rfind(ZIP_EXT + ZIP_MEMBER_SEP);
+    if (pos == std::string::npos)
+        return false;
+    archive = path.substr(0, pos + ZIP_EXT.size());
+    member = path.substr(pos + ZIP_EXT.size() + 1);
+    return true;
+}
+
+// ZipArchive maps a zip file and reads its central directory.
+// Only the features used by our archives are supported (no zip64, no encryption).
+class ZipArchive
+{
+private:
+    std::string path;
+    MappedFile file;
+    std::vector<ZipEntry> entries;
+
+    static u64 read_le(const unsigned char *p, int bytes)
+    {
+        u64 v = 0;
+        for (int i = 0; i < bytes; i++)
+            v |= static_cast<u64>(p[i]) << (8 * i);
+        return v;
+    }
+
+    [[noreturn]] void fail(const std::string &why) const
+    {
+        std::cerr << "Bad zip archive " << path << ": " << why << "\n";
+        std::exit(2);
+    }
+
+    const unsigned char *at(u64 offset, u64 bytes) const
+    {
+        if (offset > file.size() || bytes > file.size() - offset)
+            fail("truncated");
+        return reinterpret_cast<const unsigned char *>(file.begin()) + offset;
+    }
+
+public:
+    explicit ZipArchive(const std::string &path) : path(path), file(path)
+    {
+        // The end of central directory record (22 bytes) is followed by a comment of up to 64 KB.
+        static constexpr u64 EOCD_BYTES = 22;
+        if (file.size() < EOCD_BYTES)
+            fail("too small");
+
+        u64 eocd = file.size() - EOCD_BYTES;
+        u64 lowest = file.size() > EOCD_BYTES + 0xffff ? file.size() - EOCD_BYTES - 0xffff : 0;
+        while (read_le(at(eocd, 4), 4) != 0x06054b50)
+        {
+            if (eocd == lowest)
+                fail("no end of central directory");
+            eocd--;
+        }
+
+        const unsigned char *e = at(eocd, EOCD_BYTES);
+        u64 count = read_le(e + 10, 2);
+        u64 cd_offset = read_le(e + 16, 4);
+        if (cd_offset == 0xffffffff)
+            fail("zip64 is not supported");
+
+        u64 off = cd_offset;
+        for (u64 i = 0; i < count; i++)
+        {
+            const unsigned char *h = at(off, 46);
+            if (read_le(h, 4) != 0x02014b50)
+                fail("bad central directory entry");
+
+            ZipEntry entry;
+            u64 flags = read_le(h + 8, 2);
+            entry.method = static_cast<int>(read_le(h + 10, 2));
+            entry.crc = static_cast<u32>(read_le(h + 16, 4));
+            entry.comp_size = read_le(h + 20, 4);
+            entry.size = read_le(h + 24, 4);
+            u64 name_len = read_le(h + 28, 2);
+            u64 extra_len = read_le(h + 30, 2);
+            u64 comment_len = read_le(h + 32, 2);
+            entry.local_offset = read_le(h + 42, 4);
+            entry.name.assign(reinterpret_cast<const char *>(at(off + 46, name_len)), name_len);
+
+            if (flags & 1)
+                fail("encrypted member " + entry.name);
+            entries.push_back(entry);
+            off += 46 + name_len + extra_len + comment_len;
+        }
+    }
+
+    const std::vector<ZipEntry> &list() const { return entries; }
+    const std::string &archive_path() const { return path; }
+
+    // find returns the member with the exact name, or nullptr.
+    const ZipEntry *find(const std::string &name) const
+    {
+        for (const auto &entry : entries)
+        {
+            if (entry.name == name)
+                return &entry;
+        }
+        return nullptr;
+    }
+
+    // data returns the compressed bytes of the member.
+    const unsigned char *data(const ZipEntry &entry) const
+    {
+        const unsigned char *h = at(entry.local_offset, 30);
+        if (read_le(h, 4) != 0x04034b50)
+            fail("bad local header for " + entry.name);
+        u64 start = entry.local_offset + 30 + read_le(h + 26, 2) + read_le(h + 28, 2);
+        return at(start, entry.comp_size);
+    }
+};
+
+// ZipLineStream inflates one member of an archive chunk by chunk.
+// Each window it returns ends on a line boundary, so the text trace parser
+// can scan it in place; partial lines are carried over to the next window.
+class ZipLineStream
+{
+private:
+    std::shared_ptr<const ZipArchive> archive;
+    ZipEntry entry;
+    std::string name; // "<archive>.zip:<member>", for error messages.
+
+    z_stream zs{};
+    bool inflating = false;
+    bool done = false;
+    uLong crc = 0;
+    u64 produced = 0;
+
+    std::vector<char> buf;
+    size_t filled = 0;   // Bytes of buf holding inflated data.
+    size_t consumed = 0; // Bytes of buf already handed out.
+
+    [[noreturn]] void fail(const std::string &why) const
+    {
+        std::cerr << "Cannot inflate " << name << ": " << why << "\n";
+        std::exit(2);
+    }
+
+    void finish()
+    {
+        done = true;
+        if (produced != entry.size || crc != entry.crc)
+            fail("size or CRC mismatch");
+    }
+
+public:
+    ZipLineStream(std::shared_ptr<const ZipArchive> archive_, const std::string &member)
+        : archive(std::move(archive_)), name(archive->archive_path() + ZIP_MEMBER_SEP + member)
+    {
+        const ZipEntry *e = archive->find(member);
+        if (e == nullptr)
+        {
+            std::cerr << "Missing: " << name << "\n";
+            std::exit(2);
+        }
+        entry = *e;
+        if (entry.method != 0 && entry.method != 8)
+            fail("unsupported compression method " + std::to_string(entry.method));
+
+        if (entry.method == 8)
+        {
+            zs.next_in = const_cast<Bytef *>(archive->data(entry));
+            zs.avail_in = static_cast<uInt>(entry.comp_size);
+            if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) // raw deflate stream
+                fail("inflateInit2");
+            inflating = true;
+            buf.resize(ZIP_INFLATE_CHUNK_BYTES);
+        }
+    }
+
+    ~ZipLineStream()
+    {
+        if (inflating)
+            inflateEnd(&zs);
+    }
+
+    ZipLineStream(const ZipLineStream &) = delete;
+    ZipLineStream &operator=(const ZipLineStream &) = delete;
+
+    // Uncompressed size of the member in bytes.
+    u64 size() const { return entry.size; }
+
+    // next sets [begin, end) to the next window of whole lines.
+    // Returns false once the member is exhausted.
+    bool next(const char *&begin, const char *&end)
+    {
+        if (done)
+            return false;
+
+        if (entry.method == 0)
+        {
+            // Stored members are handed out in place, in one window.
+            begin = reinterpret_cast<const char *>(archive->data(entry));
+            end = begin + entry.comp_size;
+            produced = entry.comp_size;
+            crc = crc32(0L, reinterpret_cast<const Bytef *>(begin), static_cast<uInt>(entry.comp_size));
+            finish();
+            return true;
+        }
+
+        // Move the partial line left over from the previous window to the front.
+        std::memmove(buf.data(), buf.data() + consumed, filled - consumed);
+        filled -= consumed;
+        consumed = 0;
+
+        while (true)
+        {
+            if (filled == buf.size())
+                buf.resize(buf.size() * 2); // A single line longer than the buffer.
+
+            zs.next_out = reinterpret_cast<Bytef *>(buf.data() + filled);
+            zs.avail_out = static_cast<uInt>(buf.size() - filled);
+            int ret = ::inflate(&zs, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END)
+                fail(zs.msg != nullptr ? zs.msg : "inflate error");
+
+            size_t got = buf.size() - filled - zs.avail_out;
+            crc = crc32(crc, reinterpret_cast<const Bytef *>(buf.data() + filled), static_cast<uInt>(got));
+            produced += got;
+            filled += got;
+
+            if (ret == Z_STREAM_END)
+            {
+                finish();
+                if (filled == 0)
+                    return false;
+                consumed = filled;
+                break;
+            }
+            if (got == 0 && zs.avail_in == 0)
+                fail("truncated member");
+
+            // Hand out everything up to the last newline.
+            const char *nl = static_cast<const char *>(memrchr(buf.data(), '\n', filled));
+            if (nl != nullptr)
+            {
+                consumed = static_cast<size_t>(nl - buf.data()) + 1;
+                break;
+            }
+        }
+
+        begin = buf.data();
+        end = buf.data() + consumed;
+        return true;
+    }
+};